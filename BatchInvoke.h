@@ -0,0 +1,270 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef BATCH_INVOKE
+#define BATCH_INVOKE
+#pragma once
+
+#include "FunctionType.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Elements per chunk, threads are given whole chunks so that no two threads
+// write to the same cache line of the output
+#if !defined(BATCH_INVOKE_CHUNK)
+#define BATCH_INVOKE_CHUNK 4096
+#endif // !BATCH_INVOKE_CHUNK
+
+// Minimum elements per thread before BatchParallel starts another thread
+#if !defined(BATCH_INVOKE_PARALLEL_THRESHOLD)
+#define BATCH_INVOKE_PARALLEL_THRESHOLD (1 << 18)
+#endif // !BATCH_INVOKE_PARALLEL_THRESHOLD
+
+#if defined(_MSC_VER)
+#define BATCH_INVOKE_RESTRICT __restrict
+#define BATCH_INVOKE_VECTORIZE __pragma(loop(ivdep))
+#elif defined(__clang__)
+#define BATCH_INVOKE_RESTRICT __restrict__
+#define BATCH_INVOKE_VECTORIZE _Pragma("clang loop vectorize(enable) interleave(enable)")
+#elif defined(__GNUC__)
+#define BATCH_INVOKE_RESTRICT __restrict__
+#define BATCH_INVOKE_VECTORIZE _Pragma("GCC ivdep")
+#else
+#define BATCH_INVOKE_RESTRICT
+#define BATCH_INVOKE_VECTORIZE
+#endif // _MSC_VER
+
+// Contiguous view of a structure-of-arrays column
+
+template <class T>
+class BatchSpan
+{
+public:
+  BatchSpan(T* data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+  template <std::size_t Size>
+  BatchSpan(T (&array)[Size]) noexcept : data_(array), size_(Size) {}
+
+  // Any contiguous container with data() and size(), e.g. std::vector or std::array
+  template <class Container, typename = std::enable_if_t<std::is_convertible<decltype(std::declval<Container&>().data()), T*>::value>>
+  BatchSpan(Container&& container) noexcept : data_(container.data()), size_(container.size()) {}
+
+  T* Data() const noexcept { return data_; }
+  std::size_t Size() const noexcept { return size_; }
+
+private:
+  T* data_;
+  std::size_t size_;
+};
+
+// Number of threads the input may be split across, 0 for one per hardware thread
+
+struct BatchParallel
+{
+  explicit BatchParallel(std::size_t threads = 0) noexcept
+    : threads(threads != 0 ? threads : std::max<std::size_t>(std::thread::hardware_concurrency(), 1)) {}
+
+  std::size_t threads;
+};
+
+template <bool ...Values>
+struct BatchBools {};
+
+template <bool ...Values>
+using BatchAllOf = std::is_same<BatchBools<Values...>, BatchBools<(Values || true)...>>;
+
+// Batching of a deduced signature: one input column per argument, one output column for the result
+
+template <class Signature>
+struct BatchSignature
+{
+  static_assert(AlwaysFalse<Signature>, "BatchInvoke requires a function type signature.");
+};
+
+template <class Return, typename ...Args>
+struct BatchSignature<Return(Args...)>
+{
+  static_assert(sizeof...(Args) != 0, "BatchInvoke requires at least one argument to map over.");
+  static_assert(!std::is_void<Return>::value, "BatchInvoke requires a return value to store in the output span.");
+  static_assert(std::is_trivially_copyable<std::decay_t<Return>>::value, "BatchInvoke requires a trivially copyable return type.");
+  static_assert(BatchAllOf<(std::is_trivially_copyable<std::decay_t<Args>>::value && !std::is_pointer<std::decay_t<Args>>::value)...>::value,
+    "BatchInvoke requires trivially copyable, non-pointer argument types.");
+  static_assert(BatchAllOf<(!std::is_lvalue_reference<Args>::value || std::is_const<std::remove_reference_t<Args>>::value)...>::value,
+    "BatchInvoke cannot map over non-const lvalue reference arguments.");
+
+  using Output = std::decay_t<Return>;
+
+  template <class Callable>
+  static void Invoke(const BatchParallel& parallel, Callable& callable, BatchSpan<Output> output, BatchSpan<const std::decay_t<Args>>... inputs)
+  {
+    const std::size_t size = output.Size();
+    const std::size_t sizes[] = { inputs.Size()... };
+    for (std::size_t input : sizes)
+      if (input != size)
+        throw std::length_error("BatchInvoke spans must have the same size.");
+
+    // The output may be computed in place over an input with the same element
+    // size, without restrict; any other overlap is rejected
+    const std::uintptr_t addresses[] = { reinterpret_cast<std::uintptr_t>(inputs.Data())... };
+    const std::size_t widths[] = { sizeof(std::decay_t<Args>)... };
+    const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(output.Data());
+    bool aliased = false;
+    for (std::size_t i = 0; i < sizeof...(Args); ++i)
+    {
+      if (size == 0 || first >= addresses[i] + size * widths[i] || addresses[i] >= first + size * sizeof(Output))
+        continue;
+      if (first != addresses[i] || widths[i] != sizeof(Output))
+        throw std::invalid_argument("BatchInvoke output span partially overlaps an input span.");
+      aliased = true;
+    }
+
+    const std::size_t chunks = (size + BATCH_INVOKE_CHUNK - 1) / BATCH_INVOKE_CHUNK;
+    const std::size_t threads = std::min(parallel.threads, std::max<std::size_t>(size / BATCH_INVOKE_PARALLEL_THRESHOLD, 1));
+    if (threads <= 1)
+    {
+      Dispatch(aliased, callable, 0, size, output.Data(), inputs.Data()...);
+      return;
+    }
+
+    // Joins the workers also when the calling thread's range throws
+    struct Workers
+    {
+      std::vector<std::thread> threads;
+      ~Workers()
+      {
+        for (std::thread& thread : threads)
+          if (thread.joinable())
+            thread.join();
+      }
+    } workers;
+
+    // Contiguous ranges of whole chunks, the calling thread takes the last one
+    workers.threads.reserve(threads - 1);
+    for (std::size_t thread = 0; thread < threads; ++thread)
+    {
+      const std::size_t begin = std::min(chunks * thread / threads * BATCH_INVOKE_CHUNK, size);
+      const std::size_t end = std::min(chunks * (thread + 1) / threads * BATCH_INVOKE_CHUNK, size);
+      if (thread + 1 == threads)
+        Dispatch(aliased, callable, begin, end, output.Data(), inputs.Data()...);
+      else
+        workers.threads.emplace_back([&callable, aliased, begin, end, output, inputs...]() { Dispatch(aliased, callable, begin, end, output.Data(), inputs.Data()...); });
+    }
+  }
+
+private:
+  template <class Callable>
+  static void Dispatch(bool aliased, Callable& callable, std::size_t begin, std::size_t end, Output* output, const std::decay_t<Args>*... inputs)
+  {
+    if (aliased)
+      RangeInPlace(callable, begin, end, output, inputs...);
+    else
+      Range(callable, begin, end, output, inputs...);
+  }
+
+  // The output is one of the inputs: each element is read before it is written
+  template <class Callable>
+  static void RangeInPlace(Callable& callable, std::size_t begin, std::size_t end, Output* output, const std::decay_t<Args>*... inputs)
+  {
+    for (std::size_t i = begin; i < end; ++i)
+      output[i] = static_cast<Output>(callable(inputs[i]...));
+  }
+
+  // Chunked so that each inner loop has a fixed trip count the compiler can vectorize
+  template <class Callable>
+  static void Range(Callable& callable, std::size_t begin, std::size_t end,
+    Output* BATCH_INVOKE_RESTRICT output, const std::decay_t<Args>* BATCH_INVOKE_RESTRICT... inputs)
+  {
+    std::size_t index = begin;
+    for (; index + BATCH_INVOKE_CHUNK <= end; index += BATCH_INVOKE_CHUNK)
+    {
+      BATCH_INVOKE_VECTORIZE
+      for (std::size_t i = index; i < index + BATCH_INVOKE_CHUNK; ++i)
+        output[i] = static_cast<Output>(callable(inputs[i]...));
+    }
+    BATCH_INVOKE_VECTORIZE
+    for (std::size_t i = index; i < end; ++i)
+      output[i] = static_cast<Output>(callable(inputs[i]...));
+  }
+};
+
+// Function pointer known at compile time, called directly so it can be inlined into the loop
+
+template <class Function, Function Pointer>
+struct BatchFunction
+{
+  template <typename ...Values>
+  decltype(auto) operator()(const Values&... values) const { return Pointer(values...); }
+};
+
+// Public interface: BatchInvoke(function, output, inputs...)
+
+template <class Callable, typename ...Spans>
+void BatchInvoke(const BatchParallel& parallel, Callable&& callable, Spans&&... spans)
+{
+  using Decayed = std::decay_t<Callable>;
+  static_assert(!std::is_member_function_pointer<Decayed>::value, "BatchInvoke cannot map over member functions, bind the object in a lambda.");
+  static_assert(sizeof...(Spans) == FunctionType<Decayed>::Arity + 1, "BatchInvoke requires an output span followed by one input span per argument.");
+  BatchSignature<typename FunctionType<Decayed>::Type>::Invoke(parallel, callable, std::forward<Spans>(spans)...);
+}
+
+template <class Callable, typename ...Spans, typename = std::enable_if_t<!std::is_same<std::decay_t<Callable>, BatchParallel>::value>>
+void BatchInvoke(Callable&& callable, Spans&&... spans)
+{
+  BatchInvoke(BatchParallel(1), std::forward<Callable>(callable), std::forward<Spans>(spans)...);
+}
+
+template <class Function, Function Pointer, typename ...Spans>
+void BatchInvoke(const BatchParallel& parallel, Spans&&... spans)
+{
+  static_assert(sizeof...(Spans) == FunctionType<Function>::Arity + 1, "BatchInvoke requires an output span followed by one input span per argument.");
+  BatchFunction<Function, Pointer> callable;
+  BatchSignature<typename FunctionType<Function>::Type>::Invoke(parallel, callable, std::forward<Spans>(spans)...);
+}
+
+template <class Function, Function Pointer, class Output, typename ...Spans, typename = std::enable_if_t<!std::is_same<std::decay_t<Output>, BatchParallel>::value>>
+void BatchInvoke(Output&& output, Spans&&... spans)
+{
+  BatchInvoke<Function, Pointer>(BatchParallel(1), std::forward<Output>(output), std::forward<Spans>(spans)...);
+}
+
+#if !defined(FUNCTION_TYPE_CPP14)
+template <auto Pointer, typename ...Spans>
+void BatchInvoke(const BatchParallel& parallel, Spans&&... spans)
+{
+  BatchInvoke<decltype(Pointer), Pointer>(parallel, std::forward<Spans>(spans)...);
+}
+
+template <auto Pointer, class Output, typename ...Spans, typename = std::enable_if_t<!std::is_same<std::decay_t<Output>, BatchParallel>::value>>
+void BatchInvoke(Output&& output, Spans&&... spans)
+{
+  BatchInvoke<decltype(Pointer), Pointer>(BatchParallel(1), std::forward<Output>(output), std::forward<Spans>(spans)...);
+}
+#endif // !FUNCTION_TYPE_CPP14
+
+#endif // BATCH_INVOKE
@@ -0,0 +1,1251 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+// Runtime microbenchmarks. Build with optimizations enabled, for example:
+//   g++ -std=c++17 -O2 -pthread Benchmarks.cpp -o Benchmarks
+// Pass a section name (e.g. "InlineFunction") to run a single section.
+
+// Define this for ISO C++14 support
+//#define FUNCTION_TYPE_CPP14
+#include "FunctionType.h"
+#include "BatchInvoke.h"
+#include "FunctionInvoke.h"
+#include "FunctionRef.h"
+#include "FunctionRegistry.h"
+#include "InlineFunction.h"
+#if !defined(FUNCTION_TYPE_CPP14)
+#include "Bind.h"
+#include "CommandBuffer.h"
+#include "CTrampoline.h"
+#include "Dispatcher.h"
+#include "Instrument.h"
+#include "Memoize.h"
+#include "Pipeline.h"
+#include "Signal.h"
+#include "TaskExecutor.h"
+#if defined(__unix__)
+#include "SharedCall.h"
+#include <sys/wait.h>
+#endif // __unix__
+#endif // !FUNCTION_TYPE_CPP14
+#include <algorithm>
+#if !defined(FUNCTION_TYPE_CPP14)
+#include <any>
+#endif // !FUNCTION_TYPE_CPP14
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif // _MSC_VER
+
+// Optimization barrier, forces the value to be materialized in memory
+template <typename T>
+inline void DoNotOptimize(T& value)
+{
+#if defined(_MSC_VER)
+  static void* volatile sink;
+  sink = &value;
+  _ReadWriteBarrier();
+#else
+  asm volatile("" : : "r"(&value) : "memory");
+#endif // _MSC_VER
+}
+
+// Prints a single result line
+void Report(const std::string& name, double value, const char* unit)
+{
+  std::cout << std::left << std::setw(56) << name << std::right << std::setw(12) << std::fixed << std::setprecision(2)
+    << value << " " << unit << std::endl;
+}
+
+// Runs body(iterations) once to warm up, then reports the average time per iteration
+template <typename Body>
+void Benchmark(const char* name, std::size_t iterations, Body body)
+{
+  body(iterations / 10 + 1);
+  const auto start = std::chrono::steady_clock::now();
+  body(iterations);
+  const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  Report(name, elapsed / iterations, "ns/op");
+}
+
+#if defined(_MSC_VER)
+#define BENCHMARK_NOINLINE __declspec(noinline)
+#else
+#define BENCHMARK_NOINLINE __attribute__((noinline))
+#endif // _MSC_VER
+
+const char* Filter = "";
+bool Enabled(const char* section)
+{
+  return std::strstr(section, Filter) != nullptr;
+}
+
+// InlineFunction against std::function
+
+template <typename Function>
+void InlineFunctionCase(const char* construct, const char* move, const char* call)
+{
+  constexpr std::size_t iterations = 10000000;
+  void* a = &Filter; void* b = &Filter; void* c = &Filter; void* d = &Filter;
+  auto lambda = [a, b, c, d](int value) { return value + (a == b) + (c == d); };
+
+  Benchmark(construct, iterations, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      Function function(lambda);
+      DoNotOptimize(function);
+    }
+  });
+
+  Benchmark(move, iterations, [&](std::size_t count)
+  {
+    Function function(lambda);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      Function moved(std::move(function));
+      DoNotOptimize(moved);
+      function = std::move(moved);
+    }
+  });
+
+  Benchmark(call, iterations, [&](std::size_t count)
+  {
+    Function function(lambda);
+    int total = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      DoNotOptimize(function);
+      total += function(static_cast<int>(i));
+    }
+    DoNotOptimize(total);
+  });
+}
+
+void InlineFunctionBenchmarks()
+{
+  std::cout << std::endl << "InlineFunction (32 byte capture)" << std::endl << std::endl;
+  InlineFunctionCase<std::function<int(int)>>("std::function construct", "std::function move", "std::function call");
+  InlineFunctionCase<InlineFunction<int(int)>>("InlineFunction construct", "InlineFunction move", "InlineFunction call");
+  InlineFunctionCase<MoveOnlyInlineFunction<int(int)>>("MoveOnlyInlineFunction construct", "MoveOnlyInlineFunction move", "MoveOnlyInlineFunction call");
+}
+
+// FunctionRef against std::function and a template parameter, for a callback
+// API that is compiled once and invoked synchronously
+
+BENCHMARK_NOINLINE int ForEachFunctionRef(int count, FunctionRef<int(int)> callback)
+{
+  int total = 0;
+  for (int i = 0; i < count; ++i)
+    total += callback(i);
+  return total;
+}
+
+BENCHMARK_NOINLINE int ForEachStdFunction(int count, const std::function<int(int)>& callback)
+{
+  int total = 0;
+  for (int i = 0; i < count; ++i)
+    total += callback(i);
+  return total;
+}
+
+template <typename Callback>
+BENCHMARK_NOINLINE int ForEachTemplate(int count, Callback&& callback)
+{
+  int total = 0;
+  for (int i = 0; i < count; ++i)
+    total += callback(i);
+  return total;
+}
+
+void FunctionRefBenchmarks()
+{
+  constexpr std::size_t iterations = 100000;
+  constexpr int count = 1000;
+  std::cout << std::endl << "FunctionRef (" << count << " callbacks per API call, per-callback time)" << std::endl << std::endl;
+  void* a = &Filter; void* b = &Filter; void* c = &Filter; void* d = &Filter;
+  auto lambda = [a, b, c, d](int value) { return value + (a == b) + (c == d); };
+
+  Benchmark("template parameter", iterations * count, [&](std::size_t total)
+  {
+    int result = 0;
+    for (std::size_t i = 0; i < total / count; ++i)
+      result += ForEachTemplate(count, lambda);
+    DoNotOptimize(result);
+  });
+
+  Benchmark("FunctionRef", iterations * count, [&](std::size_t total)
+  {
+    int result = 0;
+    for (std::size_t i = 0; i < total / count; ++i)
+      result += ForEachFunctionRef(count, lambda);
+    DoNotOptimize(result);
+  });
+
+  Benchmark("std::function (constructed per API call)", iterations * count, [&](std::size_t total)
+  {
+    int result = 0;
+    for (std::size_t i = 0; i < total / count; ++i)
+      result += ForEachStdFunction(count, lambda);
+    DoNotOptimize(result);
+  });
+
+  std::cout << std::endl << "FunctionRef (1 callback per API call, per-call time)" << std::endl << std::endl;
+
+  Benchmark("template parameter", iterations * count, [&](std::size_t total)
+  {
+    int result = 0;
+    for (std::size_t i = 0; i < total; ++i)
+      result += ForEachTemplate(1, lambda);
+    DoNotOptimize(result);
+  });
+
+  Benchmark("FunctionRef", iterations * count, [&](std::size_t total)
+  {
+    int result = 0;
+    for (std::size_t i = 0; i < total; ++i)
+      result += ForEachFunctionRef(1, lambda);
+    DoNotOptimize(result);
+  });
+
+  Benchmark("std::function (constructed per API call)", iterations * count, [&](std::size_t total)
+  {
+    int result = 0;
+    for (std::size_t i = 0; i < total; ++i)
+      result += ForEachStdFunction(1, lambda);
+    DoNotOptimize(result);
+  });
+
+  std::cout << std::endl << "FunctionRef object size" << std::endl << std::endl;
+  Report("sizeof(FunctionRef<int(int)>)", sizeof(FunctionRef<int(int)>), "bytes");
+  Report("sizeof(std::function<int(int)>)", sizeof(std::function<int(int)>), "bytes");
+}
+
+// Nanoseconds since an arbitrary epoch
+inline std::int64_t Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Thread counts from 1 to the hardware concurrency, doubling
+std::vector<std::size_t> ThreadCounts()
+{
+  std::vector<std::size_t> counts;
+  const std::size_t maximum = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+  for (std::size_t count = 1; count < maximum; count *= 2)
+    counts.push_back(count);
+  counts.push_back(maximum);
+  return counts;
+}
+
+void Percentiles(const std::string& name, std::vector<std::int64_t>& samples)
+{
+  std::sort(samples.begin(), samples.end());
+  for (double percentile : { 0.5, 0.99, 0.999 })
+    Report(name + " p" + std::to_string(percentile * 100.0).substr(0, percentile == 0.999 ? 4 : 2),
+      static_cast<double>(samples[static_cast<std::size_t>(percentile * (samples.size() - 1))]), "ns");
+}
+
+#if !defined(FUNCTION_TYPE_CPP14)
+// Vector-of-callbacks dispatch with a rollback path, for potentially throwing
+// and noexcept callbacks. For noexcept callbacks the checkpoint, the try block
+// and the rollback are compiled out.
+
+struct Ledger
+{
+  std::uint64_t balance;
+  std::uint64_t entries;
+};
+
+template <class Callback>
+BENCHMARK_NOINLINE void DispatchCallbacks(const std::vector<Callback>& callbacks, Ledger& ledger)
+{
+  for (const Callback& callback : callbacks)
+  {
+    const Ledger saved = ledger;
+    FunctionInvokeOrRollback(callback, [&ledger, &saved]() { ledger = saved; }, ledger);
+  }
+}
+
+template <class Callback, class Lambda>
+void DispatchCase(const char* name, Lambda lambda)
+{
+  constexpr std::size_t iterations = 1000000;
+  std::vector<Callback> callbacks(64, Callback(lambda));
+  Ledger ledger{ 0, 0 };
+  Benchmark(name, iterations, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      DispatchCallbacks(callbacks, ledger);
+    DoNotOptimize(ledger);
+  });
+}
+
+void FunctionInvokeBenchmarks()
+{
+  std::cout << std::endl << "FunctionInvoke (64 FunctionRef callbacks with rollback)" << std::endl << std::endl;
+  DispatchCase<FunctionRef<void(Ledger&)>>("potentially throwing callbacks", [](Ledger& ledger) { ledger.balance += 3; ++ledger.entries; });
+  DispatchCase<FunctionRef<void(Ledger&) noexcept>>("noexcept callbacks", [](Ledger& ledger) noexcept { ledger.balance += 3; ++ledger.entries; });
+}
+#endif // !FUNCTION_TYPE_CPP14
+
+// BatchInvoke against a per-element loop through a function pointer
+
+float Kernel(float x, float y) { return x * y + 1.0f; }
+
+BENCHMARK_NOINLINE void NaiveLoop(float(*kernel)(float, float), float* output, const float* x, const float* y, std::size_t size)
+{
+  for (std::size_t i = 0; i < size; ++i)
+    output[i] = kernel(x[i], y[i]);
+}
+
+template <typename Body>
+void BatchCase(const std::string& name, std::size_t size, Body body)
+{
+  body();
+  const std::int64_t start = Now();
+  body();
+  Report(name + ", " + std::to_string(size / 1000000) + "M elements", size / ((Now() - start) / 1e9) / 1e6, "Melements/s");
+}
+
+void BatchInvokeBenchmarks()
+{
+  std::cout << std::endl << "BatchInvoke (float(float, float))" << std::endl << std::endl;
+  for (std::size_t size : { 1000000, 10000000, 100000000 })
+  {
+    std::vector<float> x(size, 1.5f), y(size, 2.0f), output(size);
+    float(*kernel)(float, float) = &Kernel;
+    DoNotOptimize(kernel);
+    BatchCase("naive loop, function pointer", size, [&]() { NaiveLoop(kernel, output.data(), x.data(), y.data(), size); });
+    BatchCase("BatchInvoke, function pointer", size, [&]() { BatchInvoke(kernel, output, x, y); });
+    BatchCase("BatchInvoke, compile-time function pointer", size, [&]() { BatchInvoke<decltype(&Kernel), &Kernel>(output, x, y); });
+    BatchCase("BatchInvoke, compile-time, all threads", size, [&]() { BatchInvoke<decltype(&Kernel), &Kernel>(BatchParallel(), output, x, y); });
+    DoNotOptimize(output);
+  }
+}
+
+#if !defined(FUNCTION_TYPE_CPP14)
+// Baseline: a single mutex-protected queue of std::function, as in a typical thread pool
+
+class FunctionThreadPool
+{
+public:
+  explicit FunctionThreadPool(std::size_t threads)
+  {
+    for (std::size_t i = 0; i < threads; ++i)
+      workers_.emplace_back([this] { Work(); });
+  }
+
+  ~FunctionThreadPool()
+  {
+    WaitIdle();
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_)
+      worker.join();
+  }
+
+  template <class Function, typename ...Args>
+  void Post(Function&& function, Args&&... args)
+  {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      ++outstanding_;
+      tasks_.emplace_back(std::bind(std::forward<Function>(function), std::forward<Args>(args)...));
+    }
+    wake_.notify_one();
+  }
+
+  void WaitIdle()
+  {
+    std::unique_lock<std::mutex> guard(mutex_);
+    idle_.wait(guard, [this] { return outstanding_ == 0; });
+  }
+
+private:
+  void Work()
+  {
+    for (;;)
+    {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> guard(mutex_);
+        wake_.wait(guard, [this] { return stop_ || !tasks_.empty(); });
+        if (tasks_.empty())
+          return;
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (--outstanding_ == 0)
+        idle_.notify_all();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::size_t outstanding_ = 0;
+  bool stop_ = false;
+};
+
+// Tasks capture 32 bytes, more than std::function stores inline, but together
+// with the argument and the result pointer still fit into a 64 byte TaskSlot
+template <class Executor>
+void ExecutorCase(const char* name)
+{
+  constexpr std::size_t tasks = 1000000;
+  constexpr std::size_t latencies = 100000;
+  for (std::size_t threads : ThreadCounts())
+  {
+    Executor executor(threads);
+    std::atomic<std::uint64_t> sink{ 0 };
+    const std::uint64_t a = 1, b = 2, c = 3;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < tasks; ++i)
+      executor.Post([&sink, a, b, c](std::uint64_t value) { sink.fetch_add(value + a + b + c, std::memory_order_relaxed); }, i);
+    executor.WaitIdle();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Report(std::string(name) + " throughput, " + std::to_string(threads) + " threads", tasks / seconds / 1e6, "Mtasks/s");
+
+    // Submit-to-start latency, tasks submitted in bursts of 64 from a single thread
+    std::vector<std::int64_t> samples(latencies);
+    for (std::size_t i = 0; i < latencies; i += 64)
+    {
+      for (std::size_t j = i; j < i + 64 && j < latencies; ++j)
+        executor.Post([&samples, j](std::int64_t submitted) { samples[j] = Now() - submitted; }, Now());
+      executor.WaitIdle();
+    }
+    Percentiles(std::string(name) + " latency, " + std::to_string(threads) + " threads", samples);
+  }
+}
+
+void TaskExecutorBenchmarks()
+{
+  std::cout << std::endl << "TaskExecutor (32 byte capture + 8 byte argument)" << std::endl << std::endl;
+  ExecutorCase<FunctionThreadPool>("std::function pool");
+  ExecutorCase<TaskExecutor>("TaskExecutor");
+}
+
+// Signal against a mutex guarded std::function list
+
+class MutexSignal
+{
+public:
+  std::size_t Connect(std::function<void(std::uint64_t)> slot)
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    slots_.push_back({ ++connections_, std::move(slot) });
+    return connections_;
+  }
+
+  void Disconnect(std::size_t connection)
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    slots_.erase(std::remove_if(slots_.begin(), slots_.end(), [connection](const auto& slot) { return slot.first == connection; }), slots_.end());
+  }
+
+  void Emit(std::uint64_t value)
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (const auto& slot : slots_)
+      slot.second(value);
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<std::pair<std::size_t, std::function<void(std::uint64_t)>>> slots_;
+  std::size_t connections_ = 0;
+};
+
+template <class SignalType>
+void SignalCase(const char* name)
+{
+  constexpr std::size_t emits = 200000;
+  for (std::size_t slots = 1; slots <= 64; slots *= 2)
+  {
+    for (bool churn : { false, true })
+    {
+      SignalType signal;
+      std::uint64_t total = 0;
+      for (std::size_t i = 0; i < slots; ++i)
+        signal.Connect([&total](std::uint64_t value) { total += value; });
+
+      // A second thread connects and disconnects a slot in a loop while the main thread emits
+      std::atomic<bool> stop{ false };
+      std::thread writer;
+      if (churn)
+        writer = std::thread([&signal, &stop]()
+        {
+          while (!stop.load(std::memory_order_relaxed))
+            signal.Disconnect(signal.Connect([](std::uint64_t) {}));
+        });
+
+      const auto start = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < emits; ++i)
+        signal.Emit(i);
+      const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      stop.store(true);
+      if (writer.joinable())
+        writer.join();
+      DoNotOptimize(total);
+      Report(std::string(name) + ", " + std::to_string(slots) + " slots" + (churn ? ", connect churn" : ""), emits / seconds / 1e6, "Memits/s");
+    }
+  }
+}
+
+void SignalBenchmarks()
+{
+  std::cout << std::endl << "Signal emit" << std::endl << std::endl;
+  SignalCase<MutexSignal>("mutex + std::function");
+  SignalCase<Signal<void(std::uint64_t)>>("Signal");
+}
+
+// Memoize against a single mutex-protected std::unordered_map
+
+BENCHMARK_NOINLINE std::uint64_t Expensive(std::uint64_t key, std::uint32_t rounds)
+{
+  std::uint64_t value = key;
+  for (std::uint32_t i = 0; i < rounds; ++i)
+    value = (value ^ (value >> 31)) * 0x9E3779B97F4A7C15ull + i;
+  return value;
+}
+
+class MutexMemoized
+{
+public:
+  std::uint64_t operator()(std::uint64_t key, std::uint32_t rounds)
+  {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      const auto found = cache_.find(key);
+      if (found != cache_.end())
+        return found->second;
+    }
+    const std::uint64_t value = Expensive(key, rounds);
+    std::lock_guard<std::mutex> guard(mutex_);
+    cache_.emplace(key, value);
+    return value;
+  }
+
+private:
+  std::mutex mutex_;
+  std::unordered_map<std::uint64_t, std::uint64_t> cache_;
+};
+
+template <class Cache>
+void MemoizeCase(const std::string& name, std::size_t keys, Cache& cache)
+{
+  constexpr std::size_t calls = 2000000;
+  for (std::size_t threads : ThreadCounts())
+  {
+    std::vector<std::thread> workers;
+    std::atomic<std::uint64_t> sink{ 0 };
+    const std::int64_t start = Now();
+    for (std::size_t thread = 0; thread < threads; ++thread)
+      workers.emplace_back([&cache, &sink, keys, threads, thread]()
+      {
+        std::uint64_t state = thread + 1, total = 0;
+        for (std::size_t i = 0; i < calls / threads; ++i)
+        {
+          state = state * 6364136223846793005ull + 1442695040888963407ull;
+          total += cache((state >> 33) % keys, 1000u);
+        }
+        sink.fetch_add(total);
+      });
+    for (std::thread& worker : workers)
+      worker.join();
+    Report(name + ", " + std::to_string(keys) + " keys, " + std::to_string(threads) + " threads", calls / ((Now() - start) / 1e9) / 1e6, "Mcalls/s");
+  }
+}
+
+void MemoizeBenchmarks()
+{
+  std::cout << std::endl << "Memoize (1000 round hash function, uniform keys)" << std::endl << std::endl;
+  auto uncached = [](std::uint64_t key, std::uint32_t rounds) { return Expensive(key, rounds); };
+  MemoizeCase("uncached", 4096, uncached);
+  for (std::size_t keys : { 4096, 65536 })
+  {
+    MutexMemoized mutex;
+    MemoizeCase("mutex + std::unordered_map, unbounded", keys, mutex);
+    auto memoized = Memoize(&Expensive, 16384);
+    MemoizeCase("Memoize, 16384 entries", keys, memoized);
+    const MemoizeStatistics statistics = memoized.Statistics();
+    Report("Memoize, " + std::to_string(keys) + " keys, hit rate", 100.0 * statistics.hits / (statistics.hits + statistics.misses), "%");
+    Report("Memoize, " + std::to_string(keys) + " keys, evictions", static_cast<double>(statistics.evictions), "");
+  }
+}
+
+// Dispatcher against std::visit and a virtual call, uniformly random message types
+
+template <std::size_t Index>
+struct BenchMessage
+{
+  std::uint64_t value;
+};
+
+template <std::size_t Index>
+struct BenchHandler
+{
+  void operator()(const BenchMessage<Index>& message, std::uint64_t& sum) const { sum = sum * 31 + message.value + Index; }
+};
+
+struct BenchVisitor
+{
+  std::uint64_t& sum;
+
+  template <std::size_t Index>
+  void operator()(const BenchMessage<Index>& message) const { BenchHandler<Index>()(message, sum); }
+};
+
+struct VirtualMessage
+{
+  virtual ~VirtualMessage() = default;
+  virtual void Handle(std::uint64_t& sum) const = 0;
+};
+
+template <std::size_t Index>
+struct VirtualBenchMessage final : VirtualMessage
+{
+  explicit VirtualBenchMessage(std::uint64_t value) : message{ value } {}
+  void Handle(std::uint64_t& sum) const override { BenchHandler<Index>()(message, sum); }
+  BenchMessage<Index> message;
+};
+
+// Tagged buffer entry, as read from a socket or a queue
+struct TaggedMessage
+{
+  std::size_t tag;
+  alignas(std::uint64_t) unsigned char payload[sizeof(std::uint64_t)];
+};
+
+template <std::size_t Index, class Variant>
+void MakeBenchMessages(std::uint64_t value, std::vector<Variant>& variants, std::vector<std::unique_ptr<VirtualMessage>>& objects, std::vector<TaggedMessage>& tagged)
+{
+  variants.emplace_back(BenchMessage<Index>{ value });
+  objects.emplace_back(new VirtualBenchMessage<Index>(value));
+  tagged.emplace_back();
+  tagged.back().tag = Index;
+  ::new (static_cast<void*>(tagged.back().payload)) BenchMessage<Index>{ value };
+}
+
+template <std::size_t ...Indices>
+void DispatcherCase(std::index_sequence<Indices...>)
+{
+  using Variant = std::variant<BenchMessage<Indices>...>;
+  using Maker = void(*)(std::uint64_t, std::vector<Variant>&, std::vector<std::unique_ptr<VirtualMessage>>&, std::vector<TaggedMessage>&);
+  constexpr Maker makers[] = { &MakeBenchMessages<Indices, Variant>... };
+  constexpr std::size_t messages = 4096;
+  constexpr std::size_t iterations = 20000000;
+
+  std::vector<Variant> variants;
+  std::vector<std::unique_ptr<VirtualMessage>> objects;
+  std::vector<TaggedMessage> tagged;
+  std::uint64_t state = 1;
+  for (std::size_t i = 0; i < messages; ++i)
+  {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    makers[(state >> 33) % sizeof...(Indices)](i, variants, objects, tagged);
+  }
+
+  const std::string types = std::to_string(sizeof...(Indices)) + " types";
+  std::uint64_t sum = 0;
+  Benchmark(("std::visit, " + types).c_str(), iterations, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      std::visit(BenchVisitor{ sum }, variants[i % messages]);
+    DoNotOptimize(sum);
+  });
+  Benchmark(("virtual call, " + types).c_str(), iterations, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      objects[i % messages]->Handle(sum);
+    DoNotOptimize(sum);
+  });
+  auto dispatcher = MakeDispatcher(BenchHandler<Indices>()...);
+  Benchmark(("Dispatcher, variant, " + types).c_str(), iterations, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      dispatcher(variants[i % messages], sum);
+    DoNotOptimize(sum);
+  });
+  Benchmark(("Dispatcher, tag and pointer, " + types).c_str(), iterations, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const TaggedMessage& message = tagged[i % messages];
+      dispatcher.Dispatch(message.tag, static_cast<const void*>(message.payload), sum);
+    }
+    DoNotOptimize(sum);
+  });
+}
+
+void DispatcherBenchmarks()
+{
+  std::cout << std::endl << "Dispatcher (4096 uniformly random messages)" << std::endl << std::endl;
+  DispatcherCase(std::make_index_sequence<4>());
+  DispatcherCase(std::make_index_sequence<16>());
+  DispatcherCase(std::make_index_sequence<64>());
+  DispatcherCase(std::make_index_sequence<256>());
+}
+
+// Three transform stages and a sink, as a Pipeline with one thread per stage
+// against the same functions fused into a single loop
+
+struct Reading
+{
+  std::uint64_t sensor;
+  std::uint64_t value;
+};
+
+Reading Decode(std::uint64_t raw) { return { raw & 0xFF, Expensive(raw, 20) }; }
+double Calibrate(const Reading& reading) { return static_cast<double>(Expensive(reading.value, 20) % 1000) * 0.001 + reading.sensor; }
+std::uint64_t Quantize(double value) { return Expensive(static_cast<std::uint64_t>(value * 1000.0), 20); }
+
+void PipelineBenchmarks()
+{
+  constexpr std::size_t elements = 2000000;
+  std::cout << std::endl << "Pipeline (decode, calibrate, quantize, sum; " << std::thread::hardware_concurrency() << " hardware threads)" << std::endl << std::endl;
+
+  std::uint64_t fused = 0;
+  std::int64_t start = Now();
+  for (std::uint64_t i = 0; i < elements; ++i)
+    fused += Quantize(Calibrate(Decode(i)));
+  DoNotOptimize(fused);
+  Report("fused loop", elements / ((Now() - start) / 1e9) / 1e6, "Melem/s");
+
+  for (std::size_t batch : { 1, 16, 64, 256 })
+  {
+    std::uint64_t sum = 0;
+    auto execution = (MakePipeline<std::uint64_t>() | &Decode | &Calibrate | &Quantize | [&sum](std::uint64_t value) { sum += value; })
+      .Start({ PIPELINE_RING_CAPACITY, batch });
+    start = Now();
+    for (std::uint64_t i = 0; i < elements; ++i)
+      execution.Push(i);
+    execution.Finish();
+    const double seconds = (Now() - start) / 1e9;
+    Report("Pipeline, batch " + std::to_string(batch) + (sum == fused ? "" : " (MISMATCH)"), elements / seconds / 1e6, "Melem/s");
+    const std::vector<PipelineStageStatistics> statistics = execution.Statistics();
+    for (std::size_t i = 0; i < statistics.size(); ++i)
+      Report("  stage " + std::to_string(i) + " utilization, peak depth " + std::to_string(statistics[i].peak) + ", stalls " + std::to_string(statistics[i].stalls),
+        100.0 * statistics[i].utilization, "%");
+  }
+}
+
+// Per-call overhead of an instrumented callback, against the bare callback.
+// Build with -DINSTRUMENT_DISABLED to check that the wrapper compiles away.
+
+BENCHMARK_NOINLINE std::uint64_t Mix(std::uint64_t value) { return value * 0x9E3779B97F4A7C15ull ^ (value >> 29); }
+
+template <class Callback>
+void InstrumentCase(const char* name, Callback callback)
+{
+  constexpr std::size_t iterations = 20000000;
+  std::uint64_t value = 1;
+  Benchmark(name, iterations, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      value = callback(value);
+    DoNotOptimize(value);
+  });
+}
+
+void InstrumentBenchmarks()
+{
+  std::cout << std::endl << "Instrument" << std::endl << std::endl;
+  InstrumentCase("bare call", &Mix);
+  InstrumentCase("Instrument", Instrument(&Mix, "Benchmarks.Mix"));
+  InstrumentCase("Instrument, 1 in 64 calls timed", Instrument(&Mix, "Benchmarks.Mix.Sampled", 64));
+  InstrumentCase("bare call, InlineFunction slot", InlineFunction<std::uint64_t(std::uint64_t)>(&Mix));
+  InstrumentCase("Instrument, InlineFunction slot", InlineFunction<std::uint64_t(std::uint64_t)>(Instrument(&Mix, "Benchmarks.Mix")));
+  InstrumentCase("std::chrono::steady_clock::now", [](std::uint64_t value)
+  {
+    return value + static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+  });
+#if !defined(INSTRUMENT_DISABLED)
+  for (const InstrumentStatistics& statistics : InstrumentSnapshot())
+    if (statistics.name == "Benchmarks.Mix")
+      Report("Instrument, recorded p50 of Mix (" + std::to_string(statistics.calls) + " calls)", statistics.p50, "ns");
+#endif // !INSTRUMENT_DISABLED
+}
+
+// Recording and replaying a frame of 1M deferred calls, against a vector of
+// std::function. Both containers are reused across frames, as in a render loop.
+
+struct World
+{
+  std::vector<float> x, y;
+  std::uint64_t moves = 0;
+};
+
+void Move(World* world, std::uint32_t entity, float dx, float dy)
+{
+  world->x[entity] += dx;
+  world->y[entity] += dy;
+  ++world->moves;
+}
+
+void CommandBufferBenchmarks()
+{
+  constexpr std::uint32_t commands = 1000000;
+  constexpr int frames = 5;
+  std::cout << std::endl << "CommandBuffer (" << commands << " commands per frame, ns per command; " << std::thread::hardware_concurrency() << " hardware threads)" << std::endl << std::endl;
+  World world;
+  world.x.resize(4096);
+  world.y.resize(4096);
+
+  std::vector<std::function<void()>> functions;
+  CommandBuffer buffer;
+  double record[2] = {}, replay[2] = {};
+  for (int frame = 0; frame <= frames; ++frame)
+  {
+    std::int64_t start = Now();
+    for (std::uint32_t i = 0; i < commands; ++i)
+    {
+      World* target = &world;
+      const std::uint32_t entity = i & 4095;
+      const float dx = 0.5f, dy = -0.25f;
+      functions.emplace_back([target, entity, dx, dy]() { Move(target, entity, dx, dy); });
+    }
+    std::int64_t middle = Now();
+    for (std::function<void()>& function : functions)
+      function();
+    functions.clear();
+    std::int64_t end = Now();
+    if (frame != 0)
+    {
+      record[0] += middle - start;
+      replay[0] += end - middle;
+    }
+
+    start = Now();
+    for (std::uint32_t i = 0; i < commands; ++i)
+      buffer.Record(&Move, &world, i & 4095, 0.5f, -0.25f);
+    middle = Now();
+    buffer.Replay();
+    end = Now();
+    if (frame != 0)
+    {
+      record[1] += middle - start;
+      replay[1] += end - middle;
+    }
+  }
+  DoNotOptimize(world.moves);
+  const double scale = 1.0 / (static_cast<double>(commands) * frames);
+  Report("std::vector<std::function<void()>>, record", record[0] * scale, "ns");
+  Report("std::vector<std::function<void()>>, replay", replay[0] * scale, "ns");
+  Report("CommandBuffer, record", record[1] * scale, "ns");
+  Report("CommandBuffer, replay", replay[1] * scale, "ns");
+  Report("CommandBuffer, arena bytes per command", static_cast<double>(buffer.Capacity()) / commands, "");
+
+  // Recording thread and replaying thread in parallel
+  DoubleCommandBuffer double_buffer;
+  std::thread replayer([&double_buffer]() { while (double_buffer.Replay()) {} });
+  const std::int64_t start = Now();
+  for (int frame = 0; frame < frames; ++frame)
+  {
+    for (std::uint32_t i = 0; i < commands; ++i)
+      double_buffer.Record(&Move, &world, i & 4095, 0.5f, -0.25f);
+    double_buffer.Submit();
+  }
+  double_buffer.Submit();
+  double_buffer.Close();
+  replayer.join();
+  Report("DoubleCommandBuffer, record and replay in parallel", (Now() - start) * scale, "ns");
+}
+
+// Looking up and calling one of 128 plugins by name, against the usual
+// type-checked registry of std::function held in std::any
+
+void FunctionRegistryBenchmarks()
+{
+  constexpr int plugins = 128;
+  constexpr std::size_t iterations = 10000000;
+  std::cout << std::endl << "FunctionRegistry (" << plugins << " plugins, lookup and call)" << std::endl << std::endl;
+
+  std::vector<std::string> names;
+  std::vector<FunctionRegistryName> hashed;
+  for (int i = 0; i < plugins; ++i)
+  {
+    names.push_back("plugin." + std::to_string(i));
+    hashed.emplace_back(names.back().c_str());
+  }
+
+  std::unordered_map<std::string, std::any> map;
+  FunctionRegistry<256> registry;
+  for (int i = 0; i < plugins; ++i)
+  {
+    const double factor = i + 1.0;
+    map.emplace(names[i], std::function<double(double)>([factor](double value) { return value * factor; }));
+    registry.Register(names[i].c_str(), [factor](double value) { return value * factor; });
+  }
+
+  double sum = 0.0;
+  Benchmark("std::unordered_map<std::string, std::any>", iterations, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const auto found = map.find(names[i & (plugins - 1)]);
+      if (auto* function = std::any_cast<std::function<double(double)>>(&found->second))
+        sum += (*function)(1.0);
+    }
+  });
+  Benchmark("FunctionRegistry, name hashed per lookup", iterations, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      if (auto* function = registry.Find<double(double)>(names[i & (plugins - 1)].c_str()))
+        sum += (*function)(1.0);
+  });
+  Benchmark("FunctionRegistry, precomputed name", iterations, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      if (auto* function = registry.Find<double(double)>(hashed[i & (plugins - 1)]))
+        sum += (*function)(1.0);
+  });
+  Benchmark("FunctionRegistry, mismatched signature", iterations, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      sum += registry.Find<float(float)>(hashed[i & (plugins - 1)]) == nullptr ? 1.0 : 0.0;
+  });
+  DoNotOptimize(sum);
+  Report("FunctionRegistry, bytes per slot", static_cast<double>(sizeof(registry)) / 256, "");
+}
+
+// Fixing the leading argument of a function applied over an array, against
+// std::bind and a capturing lambda. The loops are kept out of line so each
+// one is compiled once for its bound type, as in a generic algorithm.
+
+float Axpy(float a, float x, float y) { return a * x + y; }
+
+template <class Bound>
+BENCHMARK_NOINLINE void ApplyBound(const Bound& bound, float* output, const float* x, const float* y, std::size_t size)
+{
+  for (std::size_t i = 0; i < size; ++i)
+    output[i] = bound(x[i], y[i]);
+}
+
+template <class Bound>
+void BindCase(const char* name, const Bound& bound)
+{
+  constexpr std::size_t size = 4096;
+  std::vector<float> output(size), x(size, 1.5f), y(size, 0.5f);
+  Benchmark(name, 20000, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      ApplyBound(bound, output.data(), x.data(), y.data(), size);
+    DoNotOptimize(output);
+  });
+  std::cout << std::left << std::setw(56) << "  object size" << std::right << std::setw(12) << sizeof(Bound) << " bytes" << std::endl;
+}
+
+void BindBenchmarks()
+{
+  std::cout << std::endl << "Bind (4096 calls of a * x + y with a bound, ns per 4096 calls)" << std::endl << std::endl;
+  float a = 2.0f;
+  DoNotOptimize(a);
+  BindCase("std::bind(&Axpy, a, _1, _2)", std::bind(&Axpy, a, std::placeholders::_1, std::placeholders::_2));
+  BindCase("capturing lambda", [a](float x, float y) { return Axpy(a, x, y); });
+  BindCase("BindFront(&Axpy, a)", BindFront(&Axpy, a));
+  BindCase("BindFront(Bind<&Axpy>, a)", BindFront(Bind<&Axpy>, a));
+  BindCase("Bind<&Axpy, 2>, integer constant", Bind<&Axpy, 2>);
+}
+
+// C callbacks with a void* context: a typed lambda through MakeCTrampoline
+// against the hand-written static thunk it replaces, sorting with qsort_r and
+// searching with a bsearch-style function that takes a context
+
+struct Entry { std::uint32_t key; std::uint32_t value; };
+
+int CompareEntries(const void* a, const void* b, void* context)
+{
+  ++*static_cast<std::uint64_t*>(context);
+  const std::uint32_t left = static_cast<const Entry*>(a)->key, right = static_cast<const Entry*>(b)->key;
+  return left < right ? -1 : left > right ? 1 : 0;
+}
+
+int CompareEntriesContextFree(const void* a, const void* b)
+{
+  const std::uint32_t left = static_cast<const Entry*>(a)->key, right = static_cast<const Entry*>(b)->key;
+  return left < right ? -1 : left > right ? 1 : 0;
+}
+
+BENCHMARK_NOINLINE const void* SearchWithContext(const void* key, const void* base, std::size_t count, std::size_t size,
+  int (*compare)(const void*, const void*, void*), void* context)
+{
+  const unsigned char* first = static_cast<const unsigned char*>(base);
+  while (count > 0)
+  {
+    const unsigned char* middle = first + (count / 2) * size;
+    const int order = compare(key, middle, context);
+    if (order == 0)
+      return middle;
+    if (order > 0)
+    {
+      first = middle + size;
+      count -= count / 2 + 1;
+    }
+    else
+      count /= 2;
+  }
+  return nullptr;
+}
+
+template <class Sort>
+void SortCase(const char* name, const std::vector<Entry>& shuffled, Sort sort)
+{
+  std::vector<Entry> entries;
+  Benchmark(name, 200, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      entries = shuffled;
+      sort(entries);
+    }
+    DoNotOptimize(entries);
+  });
+}
+
+void CTrampolineBenchmarks()
+{
+  constexpr std::size_t size = 16384;
+  std::cout << std::endl << "CTrampoline (" << size << " entries, ns per sort or per " << size << " searches)" << std::endl << std::endl;
+  std::vector<Entry> shuffled(size);
+  std::uint32_t state = 12345;
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    state = state * 1664525u + 1013904223u;
+    shuffled[i] = { state, static_cast<std::uint32_t>(i) };
+  }
+
+  std::uint64_t comparisons = 0;
+  auto compare = [&comparisons](const Entry* a, const Entry* b)
+  {
+    ++comparisons;
+    return a->key < b->key ? -1 : a->key > b->key ? 1 : 0;
+  };
+  auto trampoline = MakeCTrampoline<int (*)(const void*, const void*, void*)>(compare);
+
+#if defined(__GLIBC__)
+  SortCase("qsort_r, hand-written thunk", shuffled, [&](std::vector<Entry>& entries) { qsort_r(entries.data(), entries.size(), sizeof(Entry), &CompareEntries, &comparisons); });
+  SortCase("qsort_r, MakeCTrampoline", shuffled, [&](std::vector<Entry>& entries) { qsort_r(entries.data(), entries.size(), sizeof(Entry), trampoline.function, trampoline.context); });
+#endif // __GLIBC__
+  SortCase("qsort, hand-written comparator", shuffled, [](std::vector<Entry>& entries) { std::qsort(entries.data(), entries.size(), sizeof(Entry), &CompareEntriesContextFree); });
+#if __cplusplus >= 202002L
+  auto contextFree = MakeCTrampoline<int (*)(const void*, const void*)>([](const Entry* a, const Entry* b) { return a->key < b->key ? -1 : a->key > b->key ? 1 : 0; });
+  SortCase("qsort, MakeCTrampoline captureless lambda", shuffled, [&](std::vector<Entry>& entries) { std::qsort(entries.data(), entries.size(), sizeof(Entry), contextFree.function); });
+#endif // C++20
+
+  std::vector<Entry> sorted = shuffled;
+  std::qsort(sorted.data(), sorted.size(), sizeof(Entry), &CompareEntriesContextFree);
+  std::size_t found = 0;
+  Benchmark("bsearch-style, hand-written thunk", 200, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      for (const Entry& key : shuffled)
+        found += SearchWithContext(&key, sorted.data(), sorted.size(), sizeof(Entry), &CompareEntries, &comparisons) != nullptr;
+  });
+  Benchmark("bsearch-style, MakeCTrampoline", 200, [&](std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      for (const Entry& key : shuffled)
+        found += SearchWithContext(&key, sorted.data(), sorted.size(), sizeof(Entry), trampoline.function, trampoline.context) != nullptr;
+  });
+  DoNotOptimize(found);
+  DoNotOptimize(comparisons);
+}
+
+#if defined(__unix__)
+// Cross-process calls between a parent and a forked child, against a pair of
+// pipes carrying hand-serialized arguments
+
+struct Quote { std::uint64_t id; double price; std::uint32_t quantity; };
+
+double Notional(Quote quote, double rate) { return quote.price * quote.quantity * rate; }
+
+void PipeCase()
+{
+  constexpr std::size_t calls = 100000;
+  int requests[2], responses[2];
+  if (pipe(requests) != 0 || pipe(responses) != 0)
+    return;
+  const pid_t child = fork();
+  if (child == 0)
+  {
+    close(requests[1]);
+    unsigned char buffer[sizeof(Quote) + sizeof(double)];
+    while (read(requests[0], buffer, sizeof(buffer)) == static_cast<ssize_t>(sizeof(buffer)))
+    {
+      Quote quote;
+      double rate;
+      std::memcpy(&quote, buffer, sizeof(quote));
+      std::memcpy(&rate, buffer + sizeof(quote), sizeof(rate));
+      const double result = Notional(quote, rate);
+      if (write(responses[1], &result, sizeof(result)) != static_cast<ssize_t>(sizeof(result)))
+        break;
+    }
+    _exit(0);
+  }
+  std::vector<std::int64_t> samples(calls);
+  const std::int64_t start = Now();
+  for (std::size_t i = 0; i < calls; ++i)
+  {
+    const std::int64_t sent = Now();
+    unsigned char buffer[sizeof(Quote) + sizeof(double)];
+    const Quote quote{ i, 1.5, 100 };
+    const double rate = 1.1;
+    std::memcpy(buffer, &quote, sizeof(quote));
+    std::memcpy(buffer + sizeof(quote), &rate, sizeof(rate));
+    double result = 0;
+    if (write(requests[1], buffer, sizeof(buffer)) != static_cast<ssize_t>(sizeof(buffer)) || read(responses[0], &result, sizeof(result)) != static_cast<ssize_t>(sizeof(result)))
+      break;
+    DoNotOptimize(result);
+    samples[i] = Now() - sent;
+  }
+  Report("pipe round trip throughput", calls / ((Now() - start) / 1e9) / 1e6, "Mcalls/s");
+  Percentiles("pipe round trip latency", samples);
+  close(requests[1]);
+  waitpid(child, nullptr, 0);
+  close(requests[0]); close(responses[0]); close(responses[1]);
+}
+
+void SharedCallCase()
+{
+  using Interface = SharedCallInterface<decltype(Notional)>;
+  constexpr std::size_t calls = 1000000;
+  const std::string path = "/tmp/SharedCallBenchmark." + std::to_string(getpid());
+  SharedCallChannel channel = SharedCallChannel::Create(path);
+  const pid_t child = fork();
+  if (child == 0)
+  {
+    SharedCallChannel opened = SharedCallChannel::Open(path);
+    MakeSharedCallServer<Interface>(opened, &Notional).Run();
+    _exit(0);
+  }
+  SharedCallClient<Interface> client(channel);
+
+  std::vector<std::int64_t> samples(calls / 10);
+  std::int64_t start = Now();
+  for (std::size_t i = 0; i < samples.size(); ++i)
+  {
+    const std::int64_t sent = Now();
+    double result = client.Call<0>(Quote{ i, 1.5, 100 }, 1.1);
+    DoNotOptimize(result);
+    samples[i] = Now() - sent;
+  }
+  Report("SharedCall round trip throughput", samples.size() / ((Now() - start) / 1e9) / 1e6, "Mcalls/s");
+  Percentiles("SharedCall round trip latency", samples);
+
+  for (std::size_t batch : { 1, 16, 256 })
+  {
+    start = Now();
+    for (std::size_t i = 0; i < calls; ++i)
+    {
+      client.Post<0>(Quote{ i, 1.5, 100 }, 1.1);
+      if ((i + 1) % batch == 0)
+        client.Flush();
+    }
+    client.Call<0>(Quote{ 0, 0, 0 }, 0.0);
+    Report("SharedCall one-way, " + std::to_string(batch) + " calls per doorbell", calls / ((Now() - start) / 1e9) / 1e6, "Mcalls/s");
+  }
+
+  client.Close();
+  waitpid(child, nullptr, 0);
+  std::remove(path.c_str());
+}
+
+void SharedCallBenchmarks()
+{
+  std::cout << std::endl << "SharedCall (two processes, 24 byte struct + double argument)" << std::endl << std::endl;
+  PipeCase();
+  SharedCallCase();
+}
+#endif // __unix__
+#endif // !FUNCTION_TYPE_CPP14
+
+int main(int argc, char** argv)
+{
+  if (argc > 1)
+    Filter = argv[1];
+
+  if (Enabled("InlineFunction"))
+    InlineFunctionBenchmarks();
+  if (Enabled("FunctionRef"))
+    FunctionRefBenchmarks();
+#if !defined(FUNCTION_TYPE_CPP14)
+  if (Enabled("FunctionInvoke"))
+    FunctionInvokeBenchmarks();
+#endif // !FUNCTION_TYPE_CPP14
+  if (Enabled("BatchInvoke"))
+    BatchInvokeBenchmarks();
+#if !defined(FUNCTION_TYPE_CPP14)
+  if (Enabled("TaskExecutor"))
+    TaskExecutorBenchmarks();
+  if (Enabled("Memoize"))
+    MemoizeBenchmarks();
+  if (Enabled("Signal"))
+    SignalBenchmarks();
+  if (Enabled("Dispatcher"))
+    DispatcherBenchmarks();
+  if (Enabled("Pipeline"))
+    PipelineBenchmarks();
+  if (Enabled("Instrument"))
+    InstrumentBenchmarks();
+  if (Enabled("CommandBuffer"))
+    CommandBufferBenchmarks();
+  if (Enabled("Bind"))
+    BindBenchmarks();
+  if (Enabled("CTrampoline"))
+    CTrampolineBenchmarks();
+  if (Enabled("FunctionRegistry"))
+    FunctionRegistryBenchmarks();
+#if defined(__unix__)
+  if (Enabled("SharedCall"))
+    SharedCallBenchmarks();
+#endif // __unix__
+#endif // !FUNCTION_TYPE_CPP14
+
+  return 0;
+}
@@ -0,0 +1,294 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef BIND
+#define BIND
+#pragma once
+
+// Requires ISO C++17 (auto template parameters, inline variables, if constexpr)
+
+#include "FunctionInvoke.h"
+#include "FunctionType.h"
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// The parameters left after the first Bound ones
+
+template <class List, std::size_t Bound, class Indices = std::make_index_sequence<(Bound < List::Size ? List::Size - Bound : 0)>>
+struct BindResidual;
+
+template <class List, std::size_t Bound, std::size_t ...Indices>
+struct BindResidual<List, Bound, std::index_sequence<Indices...>>
+{
+  using Type = FunctionTypeList<typename List::template At<Bound + Indices>...>;
+};
+
+// Bound callables are called through a const reference, which a mutable lambda does not accept
+template <class Function, class = void>
+struct BindConstCallable : std::true_type {};
+
+template <class Function>
+struct BindConstCallable<Function, std::enable_if_t<std::is_class<Function>::value>>
+  : std::integral_constant<bool, FunctionType<decltype(&Function::operator())>::IsConst> {};
+
+// Parameters taken by the bound values: a member function's first value is its object
+template <class Function, std::size_t Values>
+struct BindParameters
+{
+  static constexpr std::size_t Objects = std::is_member_function_pointer<Function>::value ? 1 : 0;
+  static_assert(std::is_member_function_pointer<Function>::value || std::is_pointer<Function>::value || std::is_class<Function>::value,
+    "Bind requires a function pointer, a member function pointer or a callable object.");
+  static_assert(BindConstCallable<Function>::value, "Bind requires a callable with a const call operator, mutable lambdas are not supported.");
+  static_assert(Values >= Objects, "Bind requires an object for a member function.");
+  static_assert(Values - Objects <= FunctionType<Function>::Arity, "Bind has more values than the function has parameters.");
+
+  static constexpr std::size_t Bound = Values - Objects;
+  using Residual = typename BindResidual<typename FunctionType<Function>::ArgumentList, Bound>::Type;
+};
+
+// Passes a stored value to a parameter: lvalue reference parameters see the
+// value itself, others get a copy, so rvalue reference parameters accept it
+template <class Parameter, class Value>
+decltype(auto) BindArgument(const Value& value)
+{
+  if constexpr (std::is_lvalue_reference<Parameter>::value)
+    return (value);
+  else
+    return Value(value);
+}
+
+// Compile-time partial application: the function and the values are template
+// arguments, so the bound object is empty and the call folds into a direct call
+
+template <auto Function, class Residual, auto ...Values>
+struct BindConstant;
+
+template <auto Function, typename ...Rest, auto ...Values>
+struct BindConstant<Function, FunctionTypeList<Rest...>, Values...>
+{
+  static_assert(!std::is_class<decltype(Function)>::value, "Bind requires a function pointer or a member function pointer.");
+  static_assert(std::is_invocable<decltype(Function), decltype(Values)..., Rest...>::value, "Bind values are not convertible to the function's parameters.");
+
+  using Traits = FunctionType<decltype(Function)>;
+  using Type = typename Traits::ReturnType(Rest...);
+
+  // Noexcept when the call made through FunctionInvoke is, converting the constants included
+  typename Traits::ReturnType operator()(Rest... rest) const noexcept(FunctionInvokeNothrow<decltype(Function), decltype(Values)..., Rest...>)
+  {
+    return FunctionInvoke(Function, Values..., std::forward<Rest>(rest)...);
+  }
+};
+
+template <auto Function, auto ...Values>
+inline constexpr BindConstant<Function, typename BindParameters<decltype(Function), sizeof...(Values)>::Residual, Values...> Bind{};
+
+// Storage for a callable and its runtime-bound values, ordered by decreasing
+// alignment so no padding is needed between them. Empty types take no space.
+
+template <class ...Types>
+struct BindLayout
+{
+  static constexpr std::size_t Size = sizeof...(Types);
+
+  // Index of the type stored at each position
+  static constexpr std::array<std::size_t, Size> Order()
+  {
+    constexpr std::size_t alignments[] = { alignof(Types)... };
+    std::array<std::size_t, Size> order{};
+    for (std::size_t i = 0; i < Size; ++i)
+    {
+      std::size_t j = i;
+      for (; j > 0 && alignments[order[j - 1]] < alignments[i]; --j)
+        order[j] = order[j - 1];
+      order[j] = i;
+    }
+    return order;
+  }
+
+  // Position of each type in storage
+  static constexpr std::array<std::size_t, Size> Positions()
+  {
+    std::array<std::size_t, Size> positions{};
+    for (std::size_t i = 0; i < Size; ++i)
+      positions[Order()[i]] = i;
+    return positions;
+  }
+
+  template <class Indices = std::make_index_sequence<Size>>
+  struct Storage;
+
+  template <std::size_t ...Indices>
+  struct Storage<std::index_sequence<Indices...>>
+  {
+    using Type = std::tuple<typename FunctionTypeList<Types...>::template At<Order()[Indices]>...>;
+
+    template <class Arguments>
+    static Type Make(Arguments&& arguments)
+    {
+      return Type(std::get<Order()[Indices]>(std::move(arguments))...);
+    }
+  };
+
+  using Type = typename Storage<>::Type;
+
+  template <typename ...Arguments>
+  static Type Make(Arguments&&... arguments)
+  {
+    return Storage<>::Make(std::forward_as_tuple(std::forward<Arguments>(arguments)...));
+  }
+
+  template <std::size_t Index>
+  static const auto& Get(const Type& storage) noexcept
+  {
+    return std::get<Positions()[Index]>(storage);
+  }
+};
+
+// Runtime partial application of the leading parameters
+
+template <class Function, class Residual, class ...Values>
+class BoundFunction;
+
+template <class Function, typename ...Rest, class ...Values>
+class BoundFunction<Function, FunctionTypeList<Rest...>, Values...>
+{
+  using Parameters = BindParameters<Function, sizeof...(Values)>;
+  using Layout = BindLayout<Function, Values...>;
+
+  // The object of a member function is passed as stored
+  template <std::size_t Index>
+  using Parameter = std::conditional_t<(Index < Parameters::Objects), const Function&,
+    typename FunctionType<Function>::ArgumentList::template At<(Index < Parameters::Objects ? 0 : Index - Parameters::Objects)>>;
+
+  // Whether the call made through FunctionInvoke, with the values as BindArgument passes them, cannot throw
+  template <class Indices>
+  struct NothrowCall;
+
+  template <std::size_t ...Indices>
+  struct NothrowCall<std::index_sequence<Indices...>>
+    : std::integral_constant<bool, FunctionInvokeNothrow<const Function&, decltype(BindArgument<Parameter<Indices>>(std::declval<const Values&>()))..., Rest...>> {};
+
+public:
+  using Traits = FunctionType<Function>;
+  using Type = typename Traits::ReturnType(Rest...);
+
+  // Noexcept when copying the values and the call itself cannot throw
+  static constexpr bool Nothrow = (std::is_nothrow_copy_constructible<Values>::value && ...) &&
+    NothrowCall<std::make_index_sequence<sizeof...(Values)>>::value;
+
+  template <class Callable, typename ...Arguments>
+  BoundFunction(std::in_place_t, Callable&& callable, Arguments&&... arguments)
+    : storage_(Layout::Make(std::forward<Callable>(callable), std::forward<Arguments>(arguments)...))
+  {
+  }
+
+  typename Traits::ReturnType operator()(Rest... rest) const noexcept(Nothrow)
+  {
+    return Call(std::make_index_sequence<sizeof...(Values)>(), std::forward<Rest>(rest)...);
+  }
+
+private:
+  template <std::size_t ...Indices>
+  typename Traits::ReturnType Call(std::index_sequence<Indices...>, Rest&&... rest) const noexcept(Nothrow)
+  {
+    static_assert(std::is_invocable<const Function&, decltype(BindArgument<Parameter<Indices>>(std::declval<const Values&>()))..., Rest...>::value,
+      "Bind values are not convertible to the function's parameters.");
+    return FunctionInvoke(Layout::template Get<0>(storage_), BindArgument<Parameter<Indices>>(Layout::template Get<Indices + 1>(storage_))..., std::forward<Rest>(rest)...);
+  }
+
+  typename Layout::Type storage_;
+};
+
+// Binds the leading parameters to copies of values; pass std::ref for references
+template <class Callable, typename ...Values>
+auto BindFront(Callable&& callable, Values&&... values)
+{
+  using Function = std::decay_t<Callable>;
+  return BoundFunction<Function, typename BindParameters<Function, sizeof...(Values)>::Residual, std::decay_t<Values>...>(
+    std::in_place, std::forward<Callable>(callable), std::forward<Values>(values)...);
+}
+
+// A function taking one argument at a time, called once the last one arrives.
+// Non-const lvalue reference parameters hold a reference, others a copy.
+
+template <class Parameter>
+using CurryValue = std::conditional_t<std::is_lvalue_reference<Parameter>::value && !std::is_const<std::remove_reference_t<Parameter>>::value,
+  std::reference_wrapper<std::remove_reference_t<Parameter>>, std::decay_t<Parameter>>;
+
+template <class Function, class Residual, class ...Values>
+class Curried;
+
+template <class Function, class First, typename ...Rest, class ...Values>
+class Curried<Function, FunctionTypeList<First, Rest...>, Values...>
+{
+  static_assert(!std::is_member_function_pointer<Function>::value, "Curry requires a callable, bind member functions to an object first.");
+  static_assert(BindConstCallable<Function>::value, "Curry requires a callable with a const call operator, mutable lambdas are not supported.");
+
+  using Layout = BindLayout<Function, Values...>;
+  using Traits = FunctionType<Function>;
+  using Next = std::conditional_t<sizeof...(Rest) == 0, typename Traits::ReturnType, Curried<Function, FunctionTypeList<Rest...>, Values..., CurryValue<First>>>;
+
+  template <class, class, class ...>
+  friend class Curried;
+
+public:
+  using Type = Next(First);
+
+  template <class Callable, typename ...Arguments>
+  Curried(std::in_place_t, Callable&& callable, Arguments&&... arguments)
+    : storage_(Layout::Make(std::forward<Callable>(callable), std::forward<Arguments>(arguments)...))
+  {
+  }
+
+  Next operator()(First first) const
+  {
+    return Call(std::make_index_sequence<sizeof...(Values)>(), std::forward<First>(first));
+  }
+
+private:
+  template <std::size_t ...Indices>
+  Next Call(std::index_sequence<Indices...>, First&& first) const
+  {
+    if constexpr (sizeof...(Rest) == 0)
+      return FunctionInvoke(Layout::template Get<0>(storage_),
+        BindArgument<typename Traits::ArgumentList::template At<Indices>>(Layout::template Get<Indices + 1>(storage_))..., std::forward<First>(first));
+    else
+      return Next(std::in_place, Layout::template Get<0>(storage_), Layout::template Get<Indices + 1>(storage_)..., std::forward<First>(first));
+  }
+
+  typename Layout::Type storage_;
+};
+
+template <class Callable>
+auto Curry(Callable&& callable)
+{
+  using Function = std::decay_t<Callable>;
+  static_assert(FunctionType<Function>::Arity > 0, "Curry requires a function with parameters.");
+  return Curried<Function, typename FunctionType<Function>::ArgumentList::template Apply<FunctionTypeList>>(std::in_place, std::forward<Callable>(callable));
+}
+
+#endif // BIND
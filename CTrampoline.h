@@ -0,0 +1,178 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef C_TRAMPOLINE
+#define C_TRAMPOLINE
+#pragma once
+
+// Requires ISO C++17 (if constexpr, fold expressions); context-free trampolines
+// for captureless lambdas with converted parameters require ISO C++20
+
+#include "FunctionType.h"
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// A C callback: the function pointer to pass, and the user data to pass with
+// it, nullptr when the callable is stateless. The trampoline references the
+// callable, which must outlive every call made through it.
+
+template <class CSignature>
+struct CTrampoline
+{
+  CSignature function;
+  void* context;
+};
+
+// Marks the context parameter position for automatic detection
+constexpr std::size_t CTrampolineDetect = static_cast<std::size_t>(-1);
+
+// C arguments reach the callable converted implicitly, and void pointers
+// are cast to the typed object pointers the callable takes
+
+template <class From, class To>
+struct CTrampolineConvertible : std::is_convertible<From, To> {};
+
+template <class From, class To>
+struct CTrampolineConvertible<From*, To*> : std::integral_constant<bool, std::is_convertible<From*, To*>::value ||
+  (std::is_void<From>::value && std::is_object<To>::value && (!std::is_const<From>::value || std::is_const<To>::value) &&
+    (!std::is_volatile<From>::value || std::is_volatile<To>::value))> {};
+
+template <class To, class From>
+decltype(auto) CTrampolineArgument(From&& from) noexcept
+{
+  if constexpr (std::is_pointer<std::decay_t<From>>::value && std::is_pointer<To>::value && !std::is_convertible<std::decay_t<From>, To>::value)
+    return static_cast<To>(from);
+  else
+    return std::forward<From>(from);
+}
+
+template <class CType>
+constexpr bool CTrampolineIsContext = std::is_same<CType, void*>::value || std::is_same<CType, const void*>::value;
+
+// Whether the C parameters other than Context convert to the callable's
+// parameters; Context equal to the C arity means no context parameter
+
+template <class CList, class List, std::size_t Context, class Indices = std::make_index_sequence<List::Size>>
+struct CTrampolineMatches;
+
+template <class CList, class List, std::size_t Context, std::size_t ...Indices>
+struct CTrampolineMatches<CList, List, Context, std::index_sequence<Indices...>>
+{
+  static constexpr bool Value()
+  {
+    if constexpr (CList::Size != List::Size + (Context < CList::Size ? 1 : 0))
+      return false;
+    else if constexpr (Context < CList::Size && !CTrampolineIsContext<typename CList::template At<(Context < CList::Size ? Context : 0)>>)
+      return false;
+    else
+      return (CTrampolineConvertible<typename CList::template At<(Indices < Context ? Indices : Indices + 1)>, typename List::template At<Indices>>::value && ...);
+  }
+};
+
+// The context parameter's position: the only void* (const void* when given
+// explicitly) whose removal leaves parameters the callable accepts, or none
+// when the arities match
+
+template <class CList, class List, class Indices = std::make_index_sequence<CList::Size>>
+struct CTrampolineContext;
+
+template <class CList, class List, std::size_t ...Indices>
+struct CTrampolineContext<CList, List, std::index_sequence<Indices...>>
+{
+  template <std::size_t Index>
+  static constexpr bool Candidate = std::is_same<typename CList::template At<Index>, void*>::value && CTrampolineMatches<CList, List, Index>::Value();
+  static constexpr std::size_t Candidates = (0 + ... + (Candidate<Indices> ? 1 : 0));
+  static constexpr std::size_t Find()
+  {
+    if constexpr (CList::Size == List::Size)
+      return CList::Size;
+    else
+    {
+      std::size_t position = CList::Size;
+      ((position = Candidate<Indices> ? Indices : position), ...);
+      return position;
+    }
+  }
+  static_assert(CList::Size == List::Size || Candidates <= 1, "MakeCTrampoline cannot tell the context parameter apart, pass its position explicitly.");
+  static constexpr std::size_t Value = Find();
+};
+
+template <class CSignature, class Object, std::size_t Context, bool Stateless,
+  class CList = typename FunctionType<CSignature>::ArgumentList::template Apply<FunctionTypeList>,
+  class Indices = std::make_index_sequence<FunctionType<std::decay_t<Object>>::Arity>>
+struct CTrampolineThunk;
+
+template <class Return, typename ...CArgs, class Object, std::size_t Context, bool Stateless, std::size_t ...Indices>
+struct CTrampolineThunk<Return(*)(CArgs...), Object, Context, Stateless, FunctionTypeList<CArgs...>, std::index_sequence<Indices...>>
+{
+  using List = typename FunctionType<std::remove_cv_t<Object>>::ArgumentList;
+
+  // Exceptions cannot unwind through C frames, a throwing callable terminates
+  static Return Call(CArgs... args) noexcept
+  {
+    std::tuple<CArgs&...> arguments(args...);
+    if constexpr (Stateless)
+      return static_cast<Return>(Object()(CTrampolineArgument<typename List::template At<Indices>>(std::get<(Indices < Context ? Indices : Indices + 1)>(arguments))...));
+    else
+    {
+      Object& object = *static_cast<Object*>(const_cast<void*>(static_cast<const void*>(std::get<Context>(arguments))));
+      return static_cast<Return>(object(CTrampolineArgument<typename List::template At<Indices>>(std::get<(Indices < Context ? Indices : Indices + 1)>(arguments))...));
+    }
+  }
+};
+
+// Wraps a typed callable in a C function pointer of type CSignature. The C
+// parameter carrying the user data is found by FunctionType, or given as
+// Context. Captureless lambdas, where default constructible, need no context.
+template <class CSignature, std::size_t Context = CTrampolineDetect, class Callable>
+CTrampoline<std::decay_t<CSignature>> MakeCTrampoline(Callable&& callable) noexcept
+{
+  using CPointer = std::decay_t<CSignature>;
+  using Object = std::remove_reference_t<Callable>;
+  using Traits = FunctionType<std::remove_cv_t<Object>>;
+  using CList = typename FunctionType<CPointer>::ArgumentList::template Apply<FunctionTypeList>;
+  using List = typename Traits::ArgumentList;
+  static_assert(std::is_pointer<CPointer>::value && std::is_function<std::remove_pointer_t<CPointer>>::value, "MakeCTrampoline requires a C function pointer signature.");
+  static_assert(!std::is_member_function_pointer<std::remove_cv_t<Object>>::value, "MakeCTrampoline requires a callable, bind member functions to an object first.");
+
+  constexpr std::size_t Position = Context != CTrampolineDetect ? Context : CTrampolineContext<CList, List>::Value;
+  static_assert(CTrampolineMatches<CList, List, Position>::Value(), "MakeCTrampoline callable parameters do not match the C signature.");
+  static_assert(std::is_void<typename FunctionType<CPointer>::ReturnType>::value ||
+    std::is_convertible<typename Traits::ReturnType, typename FunctionType<CPointer>::ReturnType>::value, "MakeCTrampoline callable return type does not match the C signature.");
+
+  constexpr bool Stateless = std::is_empty<std::remove_cv_t<Object>>::value && std::is_default_constructible<std::remove_cv_t<Object>>::value;
+  if constexpr (Stateless)
+    return { &CTrampolineThunk<CPointer, std::remove_cv_t<Object>, Position, true>::Call, nullptr };
+  else if constexpr (Position == CList::Size && std::is_convertible<Object, CPointer>::value)
+    return { static_cast<CPointer>(callable), nullptr };
+  else
+  {
+    static_assert(Position < CList::Size, "MakeCTrampoline requires a context parameter for a callable that is not default constructible.");
+    static_assert(std::is_lvalue_reference<Callable>::value, "MakeCTrampoline requires an lvalue callable, which must outlive the trampoline.");
+    return { &CTrampolineThunk<CPointer, Object, Position, false>::Call, const_cast<void*>(static_cast<const volatile void*>(std::addressof(callable))) };
+  }
+}
+
+#endif // C_TRAMPOLINE
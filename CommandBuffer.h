@@ -0,0 +1,359 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef COMMAND_BUFFER
+#define COMMAND_BUFFER
+#pragma once
+
+// Requires ISO C++17 (std::launder, if constexpr)
+
+#include "FunctionType.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Arena chunk size in bytes, commands larger than this get a chunk of their own
+#if !defined(COMMAND_BUFFER_CHUNK_SIZE)
+#define COMMAND_BUFFER_CHUNK_SIZE 65536
+#endif // !COMMAND_BUFFER_CHUNK_SIZE
+
+// A recorded call: the callable and its arguments, decayed to the types of
+// the callable's parameters, so conversions happen when the call is recorded
+
+template <class Function, class Arguments = typename FunctionType<Function>::ArgumentList::template Apply<FunctionTypeList>>
+struct CommandRecord;
+
+template <class Function, typename ...Args>
+struct CommandRecord<Function, FunctionTypeList<Args...>>
+{
+  static_assert(!std::is_member_function_pointer<Function>::value, "CommandBuffer requires a callable, bind member functions to an object first.");
+  static_assert(((!std::is_lvalue_reference<Args>::value || std::is_const<std::remove_reference_t<Args>>::value) && ...),
+    "CommandBuffer cannot record calls that take non-const lvalue reference arguments.");
+
+  using Arguments = std::tuple<std::decay_t<Args>...>;
+
+  Function function;
+  Arguments arguments;
+
+  void Invoke() { Invoke(std::index_sequence_for<Args...>()); }
+
+  template <std::size_t ...Indices>
+  void Invoke(std::index_sequence<Indices...>)
+  {
+    // By-value and rvalue reference parameters take the stored argument by move
+    function(static_cast<std::conditional_t<std::is_lvalue_reference<Args>::value, Args, std::decay_t<Args>&&>>(std::get<Indices>(arguments))...);
+  }
+};
+
+// Deferred calls recorded into a bump-pointer arena. Each entry is a thunk
+// pointer followed by the record; the thunk calls and destroys the record and
+// returns the entry's size. Replay walks the arena linearly and empties each
+// chunk as it passes, so rewinding the arena afterwards is O(1). Chunks are
+// kept for the next frame.
+
+class CommandBuffer
+{
+public:
+  CommandBuffer() = default;
+
+  CommandBuffer(CommandBuffer&& other) noexcept
+  {
+    *this = std::move(other);
+  }
+
+  CommandBuffer& operator=(CommandBuffer&& other) noexcept
+  {
+    if (this != &other)
+    {
+      Clear();
+      chunks_ = std::move(other.chunks_);
+      other.chunks_.clear();
+      current_ = std::exchange(other.current_, 0);
+      cursor_ = std::exchange(other.cursor_, nullptr);
+      limit_ = std::exchange(other.limit_, nullptr);
+      count_ = std::exchange(other.count_, 0);
+    }
+    return *this;
+  }
+
+  ~CommandBuffer() { Clear(); }
+
+  template <class Function, typename ...Values>
+  void Record(Function&& function, Values&&... values)
+  {
+    using Record = CommandRecord<std::decay_t<Function>>;
+    static_assert(std::tuple_size<typename Record::Arguments>::value == sizeof...(Values), "CommandBuffer recorded with the wrong number of arguments.");
+    static_assert(alignof(Record) <= alignof(std::max_align_t), "CommandBuffer cannot record over-aligned callables or arguments.");
+
+    if (static_cast<std::size_t>(limit_ - cursor_) < EntryReserve<Record>())
+      Advance(EntryReserve<Record>());
+    unsigned char* entry = cursor_;
+    ::new (static_cast<void*>(entry + EntryOffset<Record>(entry))) Record{ std::forward<Function>(function), typename Record::Arguments(std::forward<Values>(values)...) };
+    ::new (static_cast<void*>(entry)) Thunk(&Run<Record>);
+    cursor_ += EntrySize<Record>(entry);
+    ++count_;
+  }
+
+  // Calls the recorded commands in order and empties the buffer. When a
+  // command throws, the remaining commands are destroyed without being called.
+  void Replay()
+  {
+    Seal();
+    std::size_t chunk = 0, position = 0;
+    try
+    {
+      for (; chunk < chunks_.size(); ++chunk)
+      {
+        unsigned char* data = chunks_[chunk].data();
+        for (position = 0; position < chunks_[chunk].used;)
+        {
+          unsigned char* entry = data + position;
+          position += (*std::launder(reinterpret_cast<Thunk*>(entry)))(entry, true, true);
+        }
+        chunks_[chunk].used = 0;
+      }
+    }
+    catch (...)
+    {
+      // The throwing command is already destroyed, skip over it
+      unsigned char* entry = chunks_[chunk].data() + position;
+      Destroy(chunk, position + (*std::launder(reinterpret_cast<Thunk*>(entry)))(entry, false, false));
+      Rewind();
+      throw;
+    }
+    Rewind();
+  }
+
+  // Destroys the recorded commands without calling them
+  void Clear()
+  {
+    Seal();
+    Destroy(0, 0);
+    Rewind();
+  }
+
+  std::size_t Size() const { return count_; }
+  bool Empty() const { return count_ == 0; }
+
+  // Arena bytes in use, and reserved
+  std::size_t Bytes() const
+  {
+    std::size_t bytes = cursor_ != nullptr ? static_cast<std::size_t>(cursor_ - chunks_[current_].data()) : 0;
+    for (std::size_t chunk = 0; chunk < current_; ++chunk)
+      bytes += chunks_[chunk].used;
+    return bytes;
+  }
+
+  std::size_t Capacity() const
+  {
+    std::size_t capacity = 0;
+    for (const Chunk& chunk : chunks_)
+      capacity += chunk.capacity;
+    return capacity;
+  }
+
+private:
+  // Calls and destroys (invoke), destroys (destroy), or neither; returns the entry's size
+  using Thunk = std::size_t (*)(unsigned char* entry, bool invoke, bool destroy);
+
+  struct Chunk
+  {
+    std::unique_ptr<std::max_align_t[]> storage;
+    std::size_t capacity;
+    std::size_t used;
+
+    unsigned char* data() const { return reinterpret_cast<unsigned char*>(storage.get()); }
+  };
+
+  // Entries start at the thunk's alignment, so the padding before a more
+  // aligned record depends on the entry's address. Chunks are aligned to
+  // std::max_align_t, which keeps the address a valid measure of alignment.
+  template <class Record>
+  static std::size_t EntryOffset(const unsigned char* entry)
+  {
+    const std::size_t misalignment = (reinterpret_cast<std::uintptr_t>(entry) + sizeof(Thunk)) & (alignof(Record) - 1);
+    return sizeof(Thunk) + (misalignment != 0 ? alignof(Record) - misalignment : 0);
+  }
+
+  template <class Record>
+  static std::size_t EntrySize(const unsigned char* entry)
+  {
+    return (EntryOffset<Record>(entry) + sizeof(Record) + alignof(Thunk) - 1) / alignof(Thunk) * alignof(Thunk);
+  }
+
+  // The largest EntrySize over every entry address
+  template <class Record>
+  static constexpr std::size_t EntryReserve()
+  {
+    constexpr std::size_t padding = alignof(Record) > alignof(Thunk) ? alignof(Record) - alignof(Thunk) : 0;
+    return (sizeof(Thunk) + padding + sizeof(Record) + alignof(Thunk) - 1) / alignof(Thunk) * alignof(Thunk);
+  }
+
+  template <class Record>
+  static std::size_t Run(unsigned char* entry, bool invoke, bool destroy)
+  {
+    if (destroy)
+    {
+      Record& record = *std::launder(reinterpret_cast<Record*>(entry + EntryOffset<Record>(entry)));
+      struct Destroy
+      {
+        Record& record;
+        ~Destroy() { record.~Record(); }
+      } destroyer{ record };
+      if (invoke)
+        record.Invoke();
+    }
+    return EntrySize<Record>(entry);
+  }
+
+  // Moves to the next chunk that fits, allocating one when none does
+  void Advance(std::size_t size)
+  {
+    if (cursor_ != nullptr)
+    {
+      Seal();
+      ++current_;
+    }
+    while (current_ < chunks_.size() && chunks_[current_].capacity < size)
+      ++current_;
+    if (current_ == chunks_.size())
+    {
+      const std::size_t capacity = size > COMMAND_BUFFER_CHUNK_SIZE ? size : COMMAND_BUFFER_CHUNK_SIZE;
+      const std::size_t blocks = (capacity + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+      chunks_.push_back({ std::unique_ptr<std::max_align_t[]>(new std::max_align_t[blocks]), blocks * sizeof(std::max_align_t), 0 });
+    }
+    cursor_ = chunks_[current_].data();
+    limit_ = cursor_ + chunks_[current_].capacity;
+  }
+
+  // Stores the write position into the current chunk
+  void Seal()
+  {
+    if (cursor_ != nullptr)
+      chunks_[current_].used = static_cast<std::size_t>(cursor_ - chunks_[current_].data());
+  }
+
+  // Destroys the commands from the given chunk and position on, and empties those chunks
+  void Destroy(std::size_t chunk, std::size_t position)
+  {
+    for (; chunk < chunks_.size(); ++chunk, position = 0)
+    {
+      while (position < chunks_[chunk].used)
+      {
+        unsigned char* entry = chunks_[chunk].data() + position;
+        position += (*std::launder(reinterpret_cast<Thunk*>(entry)))(entry, false, true);
+      }
+      chunks_[chunk].used = 0;
+    }
+  }
+
+  // Every chunk is empty by now, only the write position goes back to the first one
+  void Rewind()
+  {
+    current_ = 0;
+    cursor_ = chunks_.empty() ? nullptr : chunks_[0].data();
+    limit_ = chunks_.empty() ? nullptr : cursor_ + chunks_[0].capacity;
+    count_ = 0;
+  }
+
+  std::vector<Chunk> chunks_;
+  std::size_t current_ = 0;
+  unsigned char* cursor_ = nullptr;  // write position in the current chunk
+  unsigned char* limit_ = nullptr;
+  std::size_t count_ = 0;
+};
+
+// Two command buffers, so one thread records the next frame while another
+// replays the previous one. Record and Submit are called from the recording
+// thread, Replay from the replaying thread.
+
+class DoubleCommandBuffer
+{
+public:
+  template <class Function, typename ...Values>
+  void Record(Function&& function, Values&&... values)
+  {
+    buffers_[recording_].Record(std::forward<Function>(function), std::forward<Values>(values)...);
+  }
+
+  // Hands the recorded commands over, waits while the previous submission is still being replayed
+  void Submit()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    replayed_.wait(lock, [this]() { return !submitted_; });
+    recording_ ^= 1;
+    submitted_ = true;
+    ready_.notify_one();
+  }
+
+  // Replays the submitted commands, waits for a submission. Returns false once closed with nothing submitted.
+  bool Replay()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this]() { return submitted_ || closed_; });
+    if (!submitted_)
+      return false;
+    CommandBuffer& buffer = buffers_[recording_ ^ 1];
+    lock.unlock();
+    struct Done
+    {
+      DoubleCommandBuffer& buffers;
+      ~Done()
+      {
+        std::lock_guard<std::mutex> guard(buffers.mutex_);
+        buffers.submitted_ = false;
+        buffers.replayed_.notify_one();
+      }
+    } done{ *this };
+    buffer.Replay();
+    return true;
+  }
+
+  void Close()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    ready_.notify_all();
+  }
+
+  // Commands recorded since the last Submit
+  std::size_t Size() const { return buffers_[recording_].Size(); }
+
+private:
+  CommandBuffer buffers_[2];
+  std::size_t recording_ = 0;
+  bool submitted_ = false;
+  bool closed_ = false;
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::condition_variable replayed_;
+};
+
+#endif // COMMAND_BUFFER
@@ -0,0 +1,170 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+// Compile-time benchmark. This file does nothing at runtime, it only forces
+// FunctionType to be instantiated for every supported qualifier permutation,
+// for every arity from 0 to COMPILE_BENCH_MAX_ARITY, and for
+// COMPILE_BENCH_RETURNS distinct return types. Build it through
+// CompileBench.py, which records wall time and peak compiler memory.
+//
+// Optional modes:
+// COMPILE_BENCH_COMPLETE_ARGUMENTS - complete every ArgumentsType
+// COMPILE_BENCH_LAST_ARGUMENT      - index the last argument through Arg<N>
+// COMPILE_BENCH_TUPLE_ELEMENT      - index it through std::tuple_element instead
+
+// Define this for ISO C++14 support
+//#define FUNCTION_TYPE_CPP14
+#include "FunctionType.h"
+#include <utility>
+
+#if !defined(COMPILE_BENCH_MAX_ARITY)
+#define COMPILE_BENCH_MAX_ARITY 32
+#endif // !COMPILE_BENCH_MAX_ARITY
+
+#if !defined(COMPILE_BENCH_RETURNS)
+#define COMPILE_BENCH_RETURNS 4
+#endif // !COMPILE_BENCH_RETURNS
+
+// Distinct, complete argument and return types
+template <std::size_t I> struct CompileBenchArg {};
+template <std::size_t I> struct CompileBenchReturn {};
+struct CompileBenchClass {};
+
+// Qualifier permutations, in the same order as the FunctionType.h specializations
+
+template <std::size_t Form, class Return, typename ...Args>
+struct CompileBenchForm;
+
+#define COMPILE_BENCH_CLASS_FORM(Form, ...) template <class Return, typename ...Args>\
+struct CompileBenchForm<Form, Return, Args...> { using Type = Return(CompileBenchClass::*)(Args...)__VA_ARGS__; };
+#define COMPILE_BENCH_FORM(Form, ...) template <class Return, typename ...Args>\
+struct CompileBenchForm<Form, Return, Args...> { using Type = Return(*)(Args...)__VA_ARGS__; };
+
+COMPILE_BENCH_CLASS_FORM(0, );
+COMPILE_BENCH_CLASS_FORM(1, const);
+COMPILE_BENCH_CLASS_FORM(2, volatile);
+COMPILE_BENCH_CLASS_FORM(3, const volatile);
+COMPILE_BENCH_CLASS_FORM(4, &);
+COMPILE_BENCH_CLASS_FORM(5, const&);
+COMPILE_BENCH_CLASS_FORM(6, volatile&);
+COMPILE_BENCH_CLASS_FORM(7, const volatile&);
+COMPILE_BENCH_CLASS_FORM(8, &&);
+COMPILE_BENCH_CLASS_FORM(9, const&&);
+COMPILE_BENCH_CLASS_FORM(10, volatile&&);
+COMPILE_BENCH_CLASS_FORM(11, const volatile&&);
+COMPILE_BENCH_FORM(12, );
+
+#if !defined(FUNCTION_TYPE_CPP14)
+COMPILE_BENCH_CLASS_FORM(13, noexcept);
+COMPILE_BENCH_CLASS_FORM(14, const noexcept);
+COMPILE_BENCH_CLASS_FORM(15, volatile noexcept);
+COMPILE_BENCH_CLASS_FORM(16, const volatile noexcept);
+COMPILE_BENCH_CLASS_FORM(17, & noexcept);
+COMPILE_BENCH_CLASS_FORM(18, const& noexcept);
+COMPILE_BENCH_CLASS_FORM(19, volatile& noexcept);
+COMPILE_BENCH_CLASS_FORM(20, const volatile& noexcept);
+COMPILE_BENCH_CLASS_FORM(21, && noexcept);
+COMPILE_BENCH_CLASS_FORM(22, const&& noexcept);
+COMPILE_BENCH_CLASS_FORM(23, volatile&& noexcept);
+COMPILE_BENCH_CLASS_FORM(24, const volatile&& noexcept);
+COMPILE_BENCH_FORM(25, noexcept);
+constexpr std::size_t CompileBenchForms = 26;
+#else
+constexpr std::size_t CompileBenchForms = 13;
+#endif // !FUNCTION_TYPE_CPP14
+
+#undef COMPILE_BENCH_CLASS_FORM
+#undef COMPILE_BENCH_FORM
+
+// Signature generation
+
+template <std::size_t Form, std::size_t Return, class Indices>
+struct CompileBenchSignature;
+
+template <std::size_t Form, std::size_t Return, std::size_t ...I>
+struct CompileBenchSignature<Form, Return, std::index_sequence<I...>>
+{
+  using Type = typename CompileBenchForm<Form, CompileBenchReturn<Return>, CompileBenchArg<I>...>::Type;
+};
+
+// Touches every member of FunctionType, the same way a typical user would
+template <class Fn, std::size_t Arity = FunctionType<Fn>::Arity>
+struct CompileBenchUse
+{
+  using Type = typename FunctionType<Fn>::Type;
+#if defined(FUNCTION_TYPE_NO_TUPLE)
+  using ArgumentsType = typename FunctionType<Fn>::ArgumentList;
+#else
+  using ArgumentsType = typename FunctionType<Fn>::ArgumentsType;
+#endif // FUNCTION_TYPE_NO_TUPLE
+  using ReturnType = typename FunctionType<Fn>::ReturnType;
+#if defined(COMPILE_BENCH_COMPLETE_ARGUMENTS)
+  static constexpr std::size_t Value = sizeof(ArgumentsType) + sizeof(ReturnType);
+#elif defined(COMPILE_BENCH_LAST_ARGUMENT) && defined(COMPILE_BENCH_TUPLE_ELEMENT)
+  static constexpr std::size_t Value = sizeof(typename std::tuple_element<Arity - 1, ArgumentsType>::type) > 0;
+#elif defined(COMPILE_BENCH_LAST_ARGUMENT)
+  static constexpr std::size_t Value = sizeof(typename FunctionType<Fn>::template Arg<Arity - 1>) > 0;
+#else
+  static constexpr std::size_t Value = 1;
+#endif // COMPILE_BENCH_COMPLETE_ARGUMENTS
+};
+
+// Nullary signatures have no argument to index
+template <class Fn>
+struct CompileBenchUse<Fn, 0>
+{
+  static constexpr std::size_t Value = 1;
+};
+
+template <std::size_t Arity, std::size_t ...Forms>
+constexpr std::size_t CompileBenchForArity(std::index_sequence<Forms...>)
+{
+  std::size_t total = 0;
+  const std::size_t values[] = { 0, CompileBenchUse<typename CompileBenchSignature<Forms / COMPILE_BENCH_RETURNS % CompileBenchForms,
+    Forms % COMPILE_BENCH_RETURNS, std::make_index_sequence<Arity>>::Type>::Value... };
+  for (std::size_t value : values)
+    total += value;
+  return total;
+}
+
+template <std::size_t ...Arities>
+constexpr std::size_t CompileBenchAll(std::index_sequence<Arities...>)
+{
+  std::size_t total = 0;
+  const std::size_t values[] = { 0, CompileBenchForArity<Arities>(std::make_index_sequence<CompileBenchForms * COMPILE_BENCH_RETURNS>())... };
+  for (std::size_t value : values)
+    total += value;
+  return total;
+}
+
+constexpr std::size_t CompileBenchSignatures = CompileBenchForms * COMPILE_BENCH_RETURNS * (COMPILE_BENCH_MAX_ARITY + 1);
+constexpr std::size_t CompileBenchResult = CompileBenchAll(std::make_index_sequence<COMPILE_BENCH_MAX_ARITY + 1>());
+
+#if !defined(COMPILE_BENCH_COMPLETE_ARGUMENTS)
+static_assert(CompileBenchResult == CompileBenchSignatures, "CompileBench did not instantiate every signature.");
+#endif // !COMPILE_BENCH_COMPLETE_ARGUMENTS
+
+int main(void)
+{
+  return CompileBenchResult == 0;
+}
@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+# *************************************************************************** #
+# The MIT License(MIT)                                                        #
+# Copyright(c) 2023 Konstantin Udovickij                                      #
+# See FunctionType.h for the full license text.                               #
+# *************************************************************************** #
+
+# Compile-time benchmark runner for FunctionType.h.
+#
+# Builds CompileBench.cpp with every available compiler under ISO C++14, C++17
+# and C++20, and records wall time, peak compiler memory and the template
+# instantiation workload. Results are compared against CompileBench.baseline;
+# the script exits with a non-zero status when a configuration regresses by
+# more than the allowed tolerance. Baseline rows are keyed by compiler,
+# standard and the -D overrides, so a reduced workload is never compared
+# against the full one.
+#
+# Usage:
+#   python3 CompileBench.py                 # measure and compare
+#   python3 CompileBench.py --update        # measure and merge the results into the baseline
+#   python3 CompileBench.py --compilers g++ --standards 17 --runs 5
+#   python3 CompileBench.py --define COMPILE_BENCH_COMPLETE_ARGUMENTS
+
+import argparse
+import json
+import os
+import re
+import resource
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+SOURCE = os.path.join(ROOT, "CompileBench.cpp")
+BASELINE = os.path.join(ROOT, "CompileBench.baseline")
+
+# Qualifier permutations exercised by CompileBench.cpp, see FunctionType.h
+FORMS = {"14": 13, "17": 26, "20": 26}
+
+
+def measure(command):
+    """Runs a compiler command, returns (seconds, peak kilobytes, output)."""
+    before = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss
+    start = time.perf_counter()
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    seconds = time.perf_counter() - start
+    after = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss
+    if result.returncode != 0:
+        sys.stderr.write(result.stdout)
+        raise RuntimeError("compilation failed: " + " ".join(command))
+    # ru_maxrss is reported in bytes on macOS, kilobytes elsewhere
+    peak = max(after, before) if sys.platform != "darwin" else max(after, before) // 1024
+    return seconds, peak, result.stdout
+
+
+def instantiation_unit(compiler):
+    """Clang counts instantiated class templates, GCC only reports the seconds spent instantiating."""
+    return "classes" if "clang" in compiler else "s"
+
+
+def instantiations(compiler, output, trace_dir):
+    """Extracts the template instantiation workload reported by the compiler, in instantiation_unit."""
+    if "clang" in compiler:
+        # -ftime-trace writes one event per instantiated class template
+        for name in os.listdir(trace_dir):
+            if name.endswith(".json"):
+                with open(os.path.join(trace_dir, name)) as trace:
+                    events = json.load(trace).get("traceEvents", [])
+                return sum(1 for event in events if event.get("name") == "InstantiateClass")
+        return None
+    match = re.search(r"template instantiation\s*:\s*([0-9.]+)", output)
+    return float(match.group(1)) if match else None
+
+
+def run(compiler, standard, defines, runs):
+    flags = ["-std=c++" + standard, "-fsyntax-only"]
+    if standard == "14":
+        flags.append("-DFUNCTION_TYPE_CPP14")
+    flags += ["-D" + define for define in defines]
+    trace_dir = tempfile.mkdtemp()
+    try:
+        samples = []
+        # The peak is tracked over all children, so measure each run in a fresh process
+        for _ in range(runs):
+            probe = [sys.executable, os.path.abspath(__file__), "--probe", compiler] + flags + [SOURCE]
+            samples.append(json.loads(subprocess.check_output(probe, universal_newlines=True)))
+        seconds = sorted(sample["seconds"] for sample in samples)[len(samples) // 2]
+        peak = max(sample["peak"] for sample in samples)
+        # Extra builds to extract the instantiation workload, not included in the timings. The
+        # Clang count is exact, the GCC time is as noisy as the wall time, so it takes the median.
+        if "clang" in compiler:
+            extra = ["-c", "-ftime-trace", "-ftime-trace-granularity=0", "-o", os.path.join(trace_dir, "bench.o")]
+            flags = [flag for flag in flags if flag != "-fsyntax-only"]
+            repeats = 1
+        else:
+            extra = ["-ftime-report"]
+            repeats = runs
+        workloads = []
+        for _ in range(repeats):
+            _, _, output = measure([compiler] + flags + extra + [SOURCE])
+            workloads.append(instantiations(compiler, output, trace_dir))
+        workloads = [workload for workload in workloads if workload is not None]
+        workload = sorted(workloads)[len(workloads) // 2] if workloads else None
+        return {"seconds": seconds, "peak": peak, "instantiations": workload, "unit": instantiation_unit(compiler)}
+    finally:
+        shutil.rmtree(trace_dir, ignore_errors=True)
+
+
+def setting(defines, name, default):
+    """Returns the numeric value of a -D override, mirroring the defaults in CompileBench.cpp."""
+    for define in defines:
+        key, _, value = define.partition("=")
+        if key == name and value:
+            return int(value)
+    return default
+
+
+def configuration(defines):
+    """The baseline key for a set of -D overrides, "-" for the default workload."""
+    return ",".join(sorted(defines)) if defines else "-"
+
+
+def load_baseline():
+    baseline = {}
+    if os.path.exists(BASELINE):
+        with open(BASELINE) as source:
+            for line in source:
+                line = line.strip()
+                if not line or line.startswith("#"):
+                    continue
+                compiler, standard, defines, seconds, peak, count, unit = line.split()[:7]
+                baseline[(compiler, standard, defines)] = {"seconds": float(seconds), "peak": int(peak),
+                                                           "instantiations": None if count == "-" else float(count), "unit": unit}
+    return baseline
+
+
+def save_baseline(baseline, results):
+    """Replaces the measured rows, rows of compilers, standards or defines that did not run are kept."""
+    rows = dict(baseline)
+    rows.update(results)
+    with open(BASELINE, "w") as target:
+        target.write("# compiler standard defines seconds peak-kb instantiations unit\n")
+        for (compiler, standard, defines), row in sorted(rows.items()):
+            count = "-" if row["instantiations"] is None else "%g" % row["instantiations"]
+            target.write("%s %s %s %.3f %d %s %s\n" % (compiler, standard, defines, row["seconds"], row["peak"], count, row["unit"]))
+
+
+def delta(value, base):
+    """Relative change, None when either side is missing."""
+    if value is None or base is None or base == 0:
+        return None
+    return float(value) / base - 1.0
+
+
+def main():
+    if len(sys.argv) > 1 and sys.argv[1] == "--probe":
+        seconds, peak, _ = measure(sys.argv[2:])
+        print(json.dumps({"seconds": seconds, "peak": peak}))
+        return 0
+
+    parser = argparse.ArgumentParser(description="FunctionType compile-time benchmark")
+    parser.add_argument("--compilers", nargs="+", default=["g++", "clang++"])
+    parser.add_argument("--standards", nargs="+", default=["14", "17", "20"])
+    parser.add_argument("--define", action="append", default=[])
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--tolerance", type=float, default=0.10, help="allowed relative regression")
+    parser.add_argument("--update", action="store_true", help="merge the results into CompileBench.baseline")
+    arguments = parser.parse_args()
+
+    baseline = load_baseline()
+    results = {}
+    regressed = False
+    defines = configuration(arguments.define)
+    # vs-base lists the relative change of the seconds, the peak and the instantiation workload
+    print("%-10s %-4s %10s %10s %8s %16s  %s" % ("compiler", "std", "signatures", "seconds", "peak-MB", "instantiation", "vs-base"))
+    for compiler in arguments.compilers:
+        if shutil.which(compiler) is None:
+            sys.stderr.write("%s not found, skipped\n" % compiler)
+            continue
+        for standard in arguments.standards:
+            result = run(compiler, standard, arguments.define, arguments.runs)
+            key = (compiler, standard, defines)
+            results[key] = result
+            signatures = FORMS[standard] * setting(arguments.define, "COMPILE_BENCH_RETURNS", 4) * \
+                (setting(arguments.define, "COMPILE_BENCH_MAX_ARITY", 32) + 1)
+            comparison = "-"
+            if key in baseline:
+                base = baseline[key]
+                deltas = [delta(result["seconds"], base["seconds"]), delta(result["peak"], base["peak"]),
+                          delta(result["instantiations"], base["instantiations"]) if base["unit"] == result["unit"] else None]
+                comparison = "/".join("-" if change is None else "%+.1f%%" % (change * 100.0) for change in deltas)
+                if any(change is not None and change > arguments.tolerance for change in deltas):
+                    regressed = True
+                    comparison += " REGRESSED"
+            count = result["instantiations"]
+            workload = "-" if count is None else "%g %s" % (count, result["unit"])
+            print("%-10s %-4s %10d %10.3f %8.1f %16s  %s" % (compiler, standard, signatures, result["seconds"],
+                  result["peak"] / 1024.0, workload, comparison))
+
+    if arguments.update:
+        save_baseline(baseline, results)
+        return 0
+    return 1 if regressed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
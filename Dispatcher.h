@@ -0,0 +1,271 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef DISPATCHER
+#define DISPATCHER
+#pragma once
+
+// Requires ISO C++17 (std::variant, fold expressions, if constexpr)
+
+#include "FunctionType.h"
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+// Number of cases of the inlining switch, larger message sets use the function pointer table
+#if !defined(DISPATCHER_SWITCH_CASES)
+#define DISPATCHER_SWITCH_CASES 16
+#endif // !DISPATCHER_SWITCH_CASES
+
+static_assert(DISPATCHER_SWITCH_CASES <= 16, "DISPATCHER_SWITCH_CASES cannot exceed the 16 cases the switch is written with.");
+
+// Message set of a dispatcher, a message's tag is its index in the set
+
+template <typename ...Messages>
+struct DispatchMessages {};
+
+template <class Set>
+struct DispatchMessageSet
+{
+  static_assert(AlwaysFalse<Set>, "Dispatcher requires a DispatchMessages<...> or std::variant<...> message set.");
+};
+
+template <typename ...Messages>
+struct DispatchMessageSet<DispatchMessages<Messages...>>
+{
+  using Type = DispatchMessages<Messages...>;
+};
+
+template <typename ...Messages>
+struct DispatchMessageSet<std::variant<Messages...>>
+{
+  using Type = DispatchMessages<Messages...>;
+};
+
+// The message type of a handler is its decayed first argument, the remaining
+// arguments are passed through by every dispatch
+
+template <class Handler, class Arguments = typename FunctionType<Handler>::ArgumentList>
+struct DispatchHandler
+{
+  static_assert(AlwaysFalse<Handler>, "Dispatcher handlers must take the message as their first argument.");
+};
+
+template <class Handler, class Message, typename ...Rest>
+struct DispatchHandler<Handler, FunctionTypeList<Message, Rest...>>
+{
+  using MessageType = std::decay_t<Message>;
+  using ReturnType = typename FunctionType<Handler>::ReturnType;
+  using RestList = FunctionTypeList<Rest...>;
+};
+
+// Instantiated per message type, so the offending type shows up in the diagnostic
+
+template <class Message, std::size_t Handlers>
+struct DispatchCoverage
+{
+  static_assert(Handlers != 0, "Dispatcher has no handler for a message type.");
+  static_assert(Handlers < 2, "Dispatcher has more than one handler for a message type.");
+  static constexpr bool value = true;
+};
+
+template <class Message, bool Known>
+struct DispatchKnown
+{
+  static_assert(Known, "Dispatcher handler takes a message type that is not in the message set.");
+  static constexpr bool value = true;
+};
+
+template <class Message, typename ...Types>
+constexpr std::size_t DispatchIndex()
+{
+  constexpr bool matches[] = { std::is_same<Message, Types>::value... };
+  std::size_t index = 0;
+  while (index < sizeof...(Types) && !matches[index])
+    ++index;
+  return index;
+}
+
+// Routes a message to the handler for its type by the message's tag. Sets of
+// up to DISPATCHER_SWITCH_CASES types go through a switch, which the compiler
+// turns into a jump table with the handlers inlined into it. Larger sets index
+// a dense table of function pointers, one indirect call per dispatch
+// regardless of the number of message types.
+
+template <class Messages, typename ...Handlers>
+class Dispatcher;
+
+template <typename ...Messages, typename ...Handlers>
+class Dispatcher<DispatchMessages<Messages...>, Handlers...>
+{
+  static_assert(sizeof...(Handlers) != 0, "Dispatcher requires at least one handler.");
+
+  using First = DispatchHandler<std::tuple_element_t<0, std::tuple<Handlers...>>>;
+
+  template <class Message>
+  static constexpr std::size_t HandlerCount()
+  {
+    return ((std::is_same<Message, typename DispatchHandler<Handlers>::MessageType>::value ? 1 : 0) + ...);
+  }
+
+  static_assert((DispatchCoverage<Messages, HandlerCount<Messages>()>::value && ...), "");
+  static_assert((DispatchKnown<typename DispatchHandler<Handlers>::MessageType,
+    DispatchIndex<typename DispatchHandler<Handlers>::MessageType, Messages...>() != sizeof...(Messages)>::value && ...), "");
+  static_assert((std::is_same<typename First::ReturnType, typename DispatchHandler<Handlers>::ReturnType>::value && ...),
+    "Dispatcher handlers must have the same return type.");
+  static_assert((std::is_same<typename First::RestList, typename DispatchHandler<Handlers>::RestList>::value && ...),
+    "Dispatcher handlers must take the same arguments after the message.");
+
+public:
+  using ReturnType = typename First::ReturnType;
+  using Variant = std::variant<Messages...>;
+
+  static constexpr std::size_t Size = sizeof...(Messages);
+
+  // Runtime tag of a message type, for tagged buffers dispatched through Dispatch
+  template <class Message>
+  static constexpr std::size_t Tag = DispatchIndex<Message, Messages...>();
+
+  explicit Dispatcher(Handlers... handlers)
+    : handlers_(std::move(handlers)...) {}
+
+  template <typename ...Values>
+  ReturnType operator()(Variant& message, Values&&... values)
+  {
+    return Route<Variant*>(message.index(), &message, std::forward<Values>(values)...);
+  }
+
+  template <typename ...Values>
+  ReturnType operator()(const Variant& message, Values&&... values)
+  {
+    return Route<const Variant*>(message.index(), &message, std::forward<Values>(values)...);
+  }
+
+  // Message of the type with the given tag, tags outside the set throw std::out_of_range
+  template <typename ...Values>
+  ReturnType Dispatch(std::size_t tag, void* message, Values&&... values)
+  {
+    return Route<void*>(tag, message, std::forward<Values>(values)...);
+  }
+
+  template <typename ...Values>
+  ReturnType Dispatch(std::size_t tag, const void* message, Values&&... values)
+  {
+    return Route<const void*>(tag, message, std::forward<Values>(values)...);
+  }
+
+private:
+  // Message with the given tag, from a variant or from an untyped pointer
+  template <std::size_t Index, class Source>
+  static decltype(auto) Access(Source source)
+  {
+    using Message = std::tuple_element_t<Index, std::tuple<Messages...>>;
+    if constexpr (std::is_void<std::remove_cv_t<std::remove_pointer_t<Source>>>::value)
+      return *std::launder(static_cast<std::conditional_t<std::is_const<std::remove_pointer_t<Source>>::value, const Message, Message>*>(source));
+    else
+      return *std::get_if<Index>(source);
+  }
+
+  template <std::size_t Index, class Source, typename ...Values>
+  static ReturnType Call(Dispatcher& self, Source source, Values&&... values)
+  {
+    using Message = std::tuple_element_t<Index, std::tuple<Messages...>>;
+    return std::get<DispatchIndex<Message, typename DispatchHandler<Handlers>::MessageType...>()>(self.handlers_)(
+      Access<Index>(source), std::forward<Values>(values)...);
+  }
+
+  template <class Source, class Indices, typename ...Values>
+  struct Entries;
+
+  template <class Source, std::size_t ...Indices, typename ...Values>
+  struct Entries<Source, std::index_sequence<Indices...>, Values...>
+  {
+    static constexpr ReturnType (*Value[])(Dispatcher&, Source, Values&&...) = { &Call<Indices, Source, Values...>... };
+  };
+
+  // A valueless variant (std::variant_npos) or a raw tag outside the set
+  template <class Source>
+  [[noreturn]] static void Invalid()
+  {
+    if constexpr (std::is_void<std::remove_cv_t<std::remove_pointer_t<Source>>>::value)
+      throw std::out_of_range("Dispatcher tag is out of range.");
+    else
+      throw std::bad_variant_access();
+  }
+
+  template <class Source, typename ...Values>
+  ReturnType Route(std::size_t tag, Source source, Values&&... values)
+  {
+    if constexpr (Size <= DISPATCHER_SWITCH_CASES)
+    {
+      // Tags outside the set share the default case with the jump table's range check
+#define DISPATCHER_CASE(Index) \
+      case Index: \
+        if constexpr (Index < Size) \
+          return Call<Index>(*this, source, std::forward<Values>(values)...); \
+        break;
+      switch (tag)
+      {
+        DISPATCHER_CASE(0) DISPATCHER_CASE(1) DISPATCHER_CASE(2) DISPATCHER_CASE(3)
+        DISPATCHER_CASE(4) DISPATCHER_CASE(5) DISPATCHER_CASE(6) DISPATCHER_CASE(7)
+        DISPATCHER_CASE(8) DISPATCHER_CASE(9) DISPATCHER_CASE(10) DISPATCHER_CASE(11)
+        DISPATCHER_CASE(12) DISPATCHER_CASE(13) DISPATCHER_CASE(14) DISPATCHER_CASE(15)
+      default:
+        break;
+      }
+#undef DISPATCHER_CASE
+      Invalid<Source>();
+    }
+    else
+    {
+      if (tag >= Size)
+        Invalid<Source>();
+      return Entries<Source, std::index_sequence_for<Messages...>, Values...>::Value[tag](*this, source, std::forward<Values>(values)...);
+    }
+  }
+
+  std::tuple<Handlers...> handlers_;
+};
+
+// Dispatcher over the handlers' message types, in handler order
+
+template <typename ...Handlers>
+auto MakeDispatcher(Handlers&&... handlers)
+{
+  return Dispatcher<DispatchMessages<typename DispatchHandler<std::decay_t<Handlers>>::MessageType...>, std::decay_t<Handlers>...>(std::forward<Handlers>(handlers)...);
+}
+
+// Dispatcher over a declared message set (DispatchMessages<...> or std::variant<...>),
+// every message type of the set must have exactly one handler
+
+template <class Set, typename ...Handlers>
+auto MakeDispatcher(Handlers&&... handlers)
+{
+  return Dispatcher<typename DispatchMessageSet<Set>::Type, std::decay_t<Handlers>...>(std::forward<Handlers>(handlers)...);
+}
+
+#endif // DISPATCHER
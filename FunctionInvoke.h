@@ -0,0 +1,168 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef FUNCTION_INVOKE
+#define FUNCTION_INVOKE
+#pragma once
+
+#include "FunctionType.h"
+#include <type_traits>
+#include <utility>
+
+// Invoke layer driven by FunctionType's qualifier metadata. Calls through it
+// are noexcept exactly when the call expression is, including the conversion
+// of each argument to its parameter, member function pointers are checked
+// against the category of the object they are called on, and rollback paths
+// are compiled out for calls that cannot throw.
+
+template <class Callable>
+constexpr bool FunctionTypeIsNoexcept = FunctionType<std::decay_t<Callable>>::IsNoexcept;
+
+// Member function pointer called on an object (or a pointer to one)
+
+template <class Object>
+struct FunctionInvokeObject
+{
+  using Type = Object&&;
+  static Object&& Get(Object&& object) noexcept { return std::forward<Object>(object); }
+};
+
+template <class Pointee>
+struct FunctionInvokeObject<Pointee*>
+{
+  using Type = Pointee&;
+  static Pointee& Get(Pointee* object) noexcept { return *object; }
+};
+
+template <class Pointee>
+struct FunctionInvokeObject<Pointee*&> : FunctionInvokeObject<Pointee*> {};
+
+template <class Pointee>
+struct FunctionInvokeObject<Pointee* const&> : FunctionInvokeObject<Pointee*> {};
+
+template <class Method, class Object>
+struct FunctionInvokeCategory
+{
+  using Traits = FunctionType<Method>;
+  using Reference = typename FunctionInvokeObject<Object>::Type;
+  using Value = std::remove_reference_t<Reference>;
+
+  static_assert(std::is_base_of<typename Traits::ClassType, std::remove_cv_t<Value>>::value, "FunctionInvoke object is not of the member function's class.");
+  static_assert(!std::is_const<Value>::value || Traits::IsConst, "FunctionInvoke cannot call a non-const member function on a const object.");
+  static_assert(!std::is_volatile<Value>::value || Traits::IsVolatile, "FunctionInvoke cannot call a non-volatile member function on a volatile object.");
+  static_assert(Traits::RefQualifier != FunctionTypeReference::RValue || std::is_rvalue_reference<Reference>::value,
+    "FunctionInvoke cannot call an rvalue-qualified member function on an lvalue.");
+  static_assert(Traits::RefQualifier != FunctionTypeReference::LValue || std::is_lvalue_reference<Reference>::value || (Traits::IsConst && !Traits::IsVolatile),
+    "FunctionInvoke cannot call a non-const lvalue-qualified member function on an rvalue.");
+  static constexpr bool value = true;
+};
+
+// Lvalue-qualified member functions are applied to an lvalue; the category
+// check only lets an rvalue through to a const& member function, so it is
+// passed as a const lvalue, as binding it to const& would
+
+template <class Method, class Object, bool LValue = FunctionType<Method>::RefQualifier == FunctionTypeReference::LValue>
+struct FunctionInvokeTarget
+{
+  using Type = typename FunctionInvokeObject<Object>::Type;
+  static typename FunctionInvokeObject<Object>::Type Get(Object&& object) noexcept { return FunctionInvokeObject<Object>::Get(std::forward<Object>(object)); }
+};
+
+template <class Method, class Object>
+struct FunctionInvokeTarget<Method, Object, true>
+{
+  using Reference = typename FunctionInvokeObject<Object>::Type;
+  using Value = std::remove_reference_t<Reference>;
+  using Type = std::conditional_t<std::is_rvalue_reference<Reference>::value, const Value&, Value&>;
+
+  static Type Get(Object&& object) noexcept
+  {
+    Reference target = FunctionInvokeObject<Object>::Get(std::forward<Object>(object));
+    return target;
+  }
+};
+
+// Whether the call made by FunctionInvoke is noexcept. A noexcept callee
+// is not enough: converting an argument to a by-value parameter may throw.
+
+template <bool Member, class Callable, typename ...Args>
+struct FunctionInvokeNothrowCall : std::integral_constant<bool, noexcept(std::declval<Callable>()(std::declval<Args>()...))> {};
+
+template <class Method, class Object, typename ...Args>
+struct FunctionInvokeNothrowCall<true, Method, Object, Args...>
+  : std::integral_constant<bool, noexcept((std::declval<typename FunctionInvokeTarget<std::decay_t<Method>, Object>::Type>().*std::declval<Method>())(std::declval<Args>()...))> {};
+
+template <class Callable, typename ...Args>
+constexpr bool FunctionInvokeNothrow = FunctionInvokeNothrowCall<std::is_member_function_pointer<std::decay_t<Callable>>::value, Callable, Args...>::value;
+
+template <class Method, class Object, typename ...Args, typename = std::enable_if_t<std::is_member_function_pointer<std::decay_t<Method>>::value>>
+decltype(auto) FunctionInvoke(Method&& method, Object&& object, Args&&... args) noexcept(FunctionInvokeNothrow<Method, Object, Args...>)
+{
+  static_assert(FunctionInvokeCategory<std::decay_t<Method>, Object>::value, "");
+  return (FunctionInvokeTarget<std::decay_t<Method>, Object>::Get(std::forward<Object>(object)).*method)(std::forward<Args>(args)...);
+}
+
+template <class Callable, typename ...Args, typename = std::enable_if_t<!std::is_member_function_pointer<std::decay_t<Callable>>::value>>
+decltype(auto) FunctionInvoke(Callable&& callable, Args&&... args) noexcept(FunctionInvokeNothrow<Callable, Args...>)
+{
+  return std::forward<Callable>(callable)(std::forward<Args>(args)...);
+}
+
+// Calls rollback and rethrows when the call throws. For calls that cannot
+// throw the try block, the landing pad and rollback itself are not emitted.
+
+template <bool Noexcept>
+struct FunctionInvokeGuard
+{
+  template <class Callable, class Rollback, typename ...Args>
+  static decltype(auto) Invoke(Callable&& callable, Rollback& rollback, Args&&... args)
+  {
+    try
+    {
+      return FunctionInvoke(std::forward<Callable>(callable), std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      rollback();
+      throw;
+    }
+  }
+};
+
+template <>
+struct FunctionInvokeGuard<true>
+{
+  template <class Callable, class Rollback, typename ...Args>
+  static decltype(auto) Invoke(Callable&& callable, Rollback&, Args&&... args) noexcept
+  {
+    return FunctionInvoke(std::forward<Callable>(callable), std::forward<Args>(args)...);
+  }
+};
+
+template <class Callable, class Rollback, typename ...Args>
+decltype(auto) FunctionInvokeOrRollback(Callable&& callable, Rollback&& rollback, Args&&... args) noexcept(FunctionInvokeNothrow<Callable, Args...>)
+{
+  return FunctionInvokeGuard<FunctionInvokeNothrow<Callable, Args...>>::Invoke(std::forward<Callable>(callable), rollback, std::forward<Args>(args)...);
+}
+
+#endif // FUNCTION_INVOKE
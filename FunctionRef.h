@@ -0,0 +1,185 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef FUNCTION_REF
+#define FUNCTION_REF
+#pragma once
+
+#include "FunctionType.h"
+#include <type_traits>
+#include <utility>
+
+// Non-owning reference to a callable: one object pointer and one thunk pointer.
+// The referenced callable must outlive every call made through the reference.
+
+union FunctionRefTarget
+{
+  void* object;
+  void(*function)();
+};
+
+template <bool Noexcept, class Return, typename ...Args>
+class FunctionRefImplementation
+{
+public:
+  using Type = Return(Args...);
+
+  // Function pointers and references
+  template <class Function, typename = std::enable_if_t<std::is_function<Function>::value>>
+  FunctionRefImplementation(Function* function) noexcept
+  {
+    Check<Function&>();
+    target_.function = reinterpret_cast<void(*)()>(function);
+    thunk_ = &InvokeFunction<Function>;
+  }
+
+  // Any other callable object, bound by address
+  template <class Callable, typename = std::enable_if_t<!std::is_base_of<FunctionRefImplementation<false, Return, Args...>, std::decay_t<Callable>>::value &&
+    !std::is_base_of<FunctionRefImplementation<true, Return, Args...>, std::decay_t<Callable>>::value &&
+    !std::is_pointer<std::decay_t<Callable>>::value && !std::is_member_pointer<std::decay_t<Callable>>::value>>
+  FunctionRefImplementation(Callable&& callable) noexcept
+  {
+    using Object = std::remove_reference_t<Callable>;
+    Check<Object&>();
+    target_.object = const_cast<void*>(static_cast<const volatile void*>(std::addressof(callable)));
+    thunk_ = &InvokeObject<Object>;
+  }
+
+  // A noexcept reference also refers to the same callable through a potentially throwing signature
+  template <bool Other, typename = std::enable_if_t<Other && !Noexcept>>
+  FunctionRefImplementation(const FunctionRefImplementation<Other, Return, Args...>& other) noexcept
+    : target_(other.target_), thunk_(other.thunk_) {}
+
+  Return operator()(Args... args) const noexcept(Noexcept)
+  {
+    return thunk_(target_, std::forward<Args>(args)...);
+  }
+
+  // Member function bound to an object, the object's value category and
+  // cv-qualification must be accepted by the member function's qualifiers
+  template <class Method, Method Pointer, class Object>
+  static FunctionRefImplementation BindMember(Object&& object) noexcept
+  {
+    static_assert(std::is_member_function_pointer<Method>::value, "FunctionRef can only bind member function pointers to objects.");
+    static_assert(std::is_convertible<decltype((std::declval<Object>().*Pointer)(std::declval<Args>()...)), Return>::value || std::is_void<Return>::value,
+      "FunctionRef member function cannot be called on this object category with the requested signature.");
+    static_assert(!Noexcept || noexcept((std::declval<Object>().*Pointer)(std::declval<Args>()...)), "FunctionRef noexcept signature requires a noexcept member function.");
+    FunctionRefImplementation reference;
+    reference.target_.object = const_cast<void*>(static_cast<const volatile void*>(std::addressof(object)));
+    reference.thunk_ = &InvokeMember<Method, Pointer, Object&&>;
+    return reference;
+  }
+
+private:
+  template <bool, class, typename ...>
+  friend class FunctionRefImplementation;
+
+  using ThunkType = Return(*)(FunctionRefTarget, Args&&...);
+
+  FunctionRefImplementation() noexcept = default;
+
+  template <class Callable>
+  static constexpr void Check()
+  {
+    static_assert(std::is_convertible<decltype(std::declval<Callable>()(std::declval<Args>()...)), Return>::value || std::is_void<Return>::value,
+      "FunctionRef callable is not invocable with the requested signature.");
+    static_assert(!Noexcept || noexcept(std::declval<Callable>()(std::declval<Args>()...)), "FunctionRef noexcept signature requires a noexcept callable.");
+  }
+
+  template <class Function>
+  static Return InvokeFunction(FunctionRefTarget target, Args&&... args) noexcept(Noexcept)
+  {
+    return static_cast<Return>(reinterpret_cast<Function*>(target.function)(std::forward<Args>(args)...));
+  }
+
+  template <class Object>
+  static Return InvokeObject(FunctionRefTarget target, Args&&... args) noexcept(Noexcept)
+  {
+    return static_cast<Return>((*static_cast<Object*>(target.object))(std::forward<Args>(args)...));
+  }
+
+  template <class Method, Method Pointer, class Object>
+  static Return InvokeMember(FunctionRefTarget target, Args&&... args) noexcept(Noexcept)
+  {
+    using Pointee = std::remove_reference_t<Object>;
+    return static_cast<Return>((static_cast<Object>(*static_cast<Pointee*>(target.object)).*Pointer)(std::forward<Args>(args)...));
+  }
+
+  FunctionRefTarget target_;
+  ThunkType thunk_;
+};
+
+// Public interface
+
+template <class Signature>
+class FunctionRef
+{
+  static_assert(AlwaysFalse<Signature>, "FunctionRef requires a function type signature.");
+};
+
+template <class Return, typename ...Args>
+class FunctionRef<Return(Args...)> : public FunctionRefImplementation<false, Return, Args...>
+{
+public:
+  using FunctionRefImplementation<false, Return, Args...>::FunctionRefImplementation;
+  FunctionRef(const FunctionRefImplementation<false, Return, Args...>& other) noexcept
+    : FunctionRefImplementation<false, Return, Args...>(other) {}
+};
+
+#if !defined(FUNCTION_TYPE_CPP14)
+template <class Return, typename ...Args>
+class FunctionRef<Return(Args...) noexcept> : public FunctionRefImplementation<true, Return, Args...>
+{
+public:
+  using FunctionRefImplementation<true, Return, Args...>::FunctionRefImplementation;
+  FunctionRef(const FunctionRefImplementation<true, Return, Args...>& other) noexcept
+    : FunctionRefImplementation<true, Return, Args...>(other) {}
+};
+
+template <class Callable>
+FunctionRef(Callable&&) -> FunctionRef<FunctionTypeExactSignature<std::decay_t<Callable>>>;
+#endif // !FUNCTION_TYPE_CPP14
+
+// Signature deduction, noexcept callables give a noexcept signature
+
+template <class Callable>
+FunctionRef<FunctionTypeExactSignature<std::decay_t<Callable>>> MakeFunctionRef(Callable&& callable) noexcept
+{
+  return { std::forward<Callable>(callable) };
+}
+
+template <class Method, Method Pointer, class Object>
+FunctionRef<FunctionTypeExactSignature<Method>> MakeFunctionRef(Object&& object) noexcept
+{
+  return FunctionRef<FunctionTypeExactSignature<Method>>::template BindMember<Method, Pointer>(std::forward<Object>(object));
+}
+
+#if !defined(FUNCTION_TYPE_CPP14)
+template <auto Pointer, class Object>
+FunctionRef<FunctionTypeExactSignature<decltype(Pointer)>> MakeFunctionRef(Object&& object) noexcept
+{
+  return MakeFunctionRef<decltype(Pointer), Pointer>(std::forward<Object>(object));
+}
+#endif // !FUNCTION_TYPE_CPP14
+
+#endif // FUNCTION_REF
@@ -0,0 +1,220 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef FUNCTION_REGISTRY
+#define FUNCTION_REGISTRY
+#pragma once
+
+#include "FunctionRef.h"
+#include "FunctionType.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Default number of slots, a power of two; one slot always stays empty
+#if !defined(FUNCTION_REGISTRY_CAPACITY)
+#define FUNCTION_REGISTRY_CAPACITY 256
+#endif // !FUNCTION_REGISTRY_CAPACITY
+
+// Default bytes of in-place storage per registered callable
+#if !defined(FUNCTION_REGISTRY_STORAGE)
+#define FUNCTION_REGISTRY_STORAGE (4 * sizeof(void*))
+#endif // !FUNCTION_REGISTRY_STORAGE
+
+// A registered name, hashed once. Constructed implicitly from a string, or
+// ahead of time as a constexpr variable so lookups skip hashing.
+
+struct FunctionRegistryName
+{
+  constexpr FunctionRegistryName(const char* name) : hash(FunctionTypeHashBasis)
+  {
+    for (; *name != '\0'; ++name)
+      hash = FunctionTypeHashByte(hash, static_cast<unsigned char>(*name));
+  }
+
+  constexpr FunctionRegistryName(const char* name, std::size_t length) : hash(FunctionTypeHashBasis)
+  {
+    for (std::size_t i = 0; i < length; ++i)
+      hash = FunctionTypeHashByte(hash, static_cast<unsigned char>(name[i]));
+  }
+
+  std::uint64_t hash;
+};
+
+// An explicit signature, or the callable's own when void
+template <class Signature, class Callable>
+struct FunctionRegistryRegistered
+{
+  using Type = Signature;
+};
+
+template <class Callable>
+struct FunctionRegistryRegistered<void, Callable>
+{
+  using Type = FunctionTypeExactSignature<Callable>;
+};
+
+// The exact identity of a signature: one address per type, unlike fingerprints,
+// which may collide for distinct types of the same shape
+
+template <class Signature>
+struct FunctionRegistryIdentity
+{
+  static const char Tag;
+};
+
+template <class Signature>
+const char FunctionRegistryIdentity<Signature>::Tag = 0;
+
+// Callables stored in place in an open-addressing table keyed by name and
+// signature fingerprint, without RTTI or allocation. Slots also record the
+// signature's identity, so types with the same fingerprint never match. The
+// same name may be registered once per signature. Find returns a reference
+// typed by the requested signature, or nullptr when nothing was registered
+// under that name with exactly that signature. Entries stay at their address for the
+// registry's lifetime, so returned references stay valid.
+
+template <std::size_t Capacity = FUNCTION_REGISTRY_CAPACITY, std::size_t Storage = FUNCTION_REGISTRY_STORAGE>
+class FunctionRegistry
+{
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "FunctionRegistry requires a power of two capacity.");
+
+public:
+  FunctionRegistry() = default;
+  FunctionRegistry(const FunctionRegistry&) = delete;
+  FunctionRegistry& operator=(const FunctionRegistry&) = delete;
+
+  ~FunctionRegistry()
+  {
+    for (Slot& slot : slots_)
+      if (slot.used && slot.destroy != nullptr)
+        slot.destroy(slot.storage);
+  }
+
+  // Registers under the callable's own signature, or under Signature when given.
+  // Returns false when the name is taken for that signature or the registry is full.
+  template <class Signature = void, class Callable>
+  bool Register(FunctionRegistryName name, Callable&& callable)
+  {
+    using Stored = std::decay_t<Callable>;
+    using Registered = typename FunctionRegistryRegistered<Signature, Stored>::Type;
+    static_assert(!std::is_member_pointer<Stored>::value, "FunctionRegistry requires a callable, bind member functions to an object first.");
+    static_assert(std::is_function<Registered>::value, "FunctionRegistry requires a function type signature.");
+
+    Slot* slot = Insert(name.hash, FunctionType<Registered*>::Fingerprint(), &FunctionRegistryIdentity<Registered>::Tag);
+    if (slot == nullptr)
+      return false;
+    Store<Registered, Stored>(*slot, std::forward<Callable>(callable));
+    return true;
+  }
+
+  template <class Signature>
+  const FunctionRef<Signature>* Find(FunctionRegistryName name) const
+  {
+    static_assert(std::is_function<Signature>::value, "FunctionRegistry requires a function type signature.");
+    const std::uint64_t fingerprint = FunctionType<Signature*>::Fingerprint();
+    for (std::size_t index = Index(name.hash, fingerprint);; index = (index + 1) & (Capacity - 1))
+    {
+      const Slot& slot = slots_[index];
+      if (!slot.used)
+        return nullptr;
+      if (slot.name == name.hash && slot.fingerprint == fingerprint && slot.identity == &FunctionRegistryIdentity<Signature>::Tag)
+      {
+#if !defined(FUNCTION_TYPE_CPP14)
+        return std::launder(reinterpret_cast<const FunctionRef<Signature>*>(slot.reference));
+#else
+        return reinterpret_cast<const FunctionRef<Signature>*>(slot.reference);
+#endif // !FUNCTION_TYPE_CPP14
+      }
+    }
+  }
+
+  std::size_t Size() const { return size_; }
+
+private:
+  // Every FunctionRef is an object pointer and a thunk pointer, whatever the signature
+  using Reference = FunctionRef<void()>;
+
+  struct Slot
+  {
+    std::uint64_t name = 0;
+    std::uint64_t fingerprint = 0;
+    const void* identity = nullptr;
+    alignas(Reference) unsigned char reference[sizeof(Reference)];
+    void (*destroy)(void*) = nullptr;
+    bool used = false;
+    alignas(std::max_align_t) unsigned char storage[Storage];
+  };
+
+  static std::size_t Index(std::uint64_t name, std::uint64_t fingerprint)
+  {
+    return static_cast<std::size_t>(((name ^ fingerprint) * 0x9E3779B97F4A7C15ull) >> 32) & (Capacity - 1);
+  }
+
+  Slot* Insert(std::uint64_t name, std::uint64_t fingerprint, const void* identity)
+  {
+    if (size_ == Capacity - 1)
+      return nullptr;
+    for (std::size_t index = Index(name, fingerprint);; index = (index + 1) & (Capacity - 1))
+    {
+      Slot& slot = slots_[index];
+      if (slot.used && slot.name == name && slot.identity == identity)
+        return nullptr;
+      if (!slot.used)
+      {
+        slot.name = name;
+        slot.fingerprint = fingerprint;
+        slot.identity = identity;
+        return &slot;
+      }
+    }
+  }
+
+  // Function pointers are referenced directly, other callables are copied into the slot
+  template <class Signature, class Stored, class Callable>
+  std::enable_if_t<std::is_pointer<Stored>::value> Store(Slot& slot, Callable&& callable)
+  {
+    ::new (static_cast<void*>(slot.reference)) FunctionRef<Signature>(static_cast<Stored>(callable));
+    slot.used = true;
+    ++size_;
+  }
+
+  template <class Signature, class Stored, class Callable>
+  std::enable_if_t<!std::is_pointer<Stored>::value> Store(Slot& slot, Callable&& callable)
+  {
+    static_assert(sizeof(Stored) <= Storage, "FunctionRegistry storage is too small for this callable.");
+    static_assert(alignof(Stored) <= alignof(std::max_align_t), "FunctionRegistry does not support over-aligned callables.");
+    Stored* stored = ::new (static_cast<void*>(slot.storage)) Stored(std::forward<Callable>(callable));
+    ::new (static_cast<void*>(slot.reference)) FunctionRef<Signature>(*stored);
+    slot.destroy = [](void* storage) { static_cast<Stored*>(storage)->~Stored(); };
+    slot.used = true;
+    ++size_;
+  }
+
+  Slot slots_[Capacity];
+  std::size_t size_ = 0;
+};
+
+#endif // FUNCTION_REGISTRY
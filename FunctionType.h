@@ -25,44 +25,395 @@
 #define FUNCTION_TYPE
 #pragma once
 
+// Define FUNCTION_TYPE_NO_TUPLE to drop ArgumentsType and the <tuple> dependency,
+// ArgumentList::Apply<std::tuple> yields the same type on demand
+#if !defined(FUNCTION_TYPE_NO_TUPLE)
 #include <tuple>
+#endif // !FUNCTION_TYPE_NO_TUPLE
 #include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
 
 template <class>
 constexpr bool AlwaysFalse = false;
 
+// Argument indexing, constant instantiation depth regardless of the arity
+
+#if defined(__has_builtin)
+#if __has_builtin(__type_pack_element)
+#define FUNCTION_TYPE_PACK_ELEMENT
+#endif // __has_builtin(__type_pack_element)
+#endif // __has_builtin
+
+#if defined(FUNCTION_TYPE_PACK_ELEMENT)
+template <std::size_t Index, typename ...Args>
+struct FunctionTypeElement
+{
+  static_assert(Index < sizeof...(Args), "FunctionType argument index is out of range.");
+  using Type = __type_pack_element<Index, Args...>;
+};
+#else
+template <std::size_t Index, class Arg>
+struct FunctionTypeIndexed
+{
+  using Type = Arg;
+};
+
+template <class Indices, typename ...Args>
+struct FunctionTypeIndexer;
+
+template <std::size_t ...Indices, typename ...Args>
+struct FunctionTypeIndexer<std::index_sequence<Indices...>, Args...> : public FunctionTypeIndexed<Indices, Args>... {};
+
+template <std::size_t Index, class Arg>
+FunctionTypeIndexed<Index, Arg> FunctionTypeSelect(const FunctionTypeIndexed<Index, Arg>&);
+
+template <std::size_t Index, typename ...Args>
+struct FunctionTypeElement
+{
+  static_assert(Index < sizeof...(Args), "FunctionType argument index is out of range.");
+  using Type = typename decltype(FunctionTypeSelect<Index>(std::declval<FunctionTypeIndexer<std::index_sequence_for<Args...>, Args...>>()))::Type;
+};
+#endif // FUNCTION_TYPE_PACK_ELEMENT
+
+#undef FUNCTION_TYPE_PACK_ELEMENT
+
+// Tuple-free argument type list
+
+template <typename ...Args>
+struct FunctionTypeList
+{
+  static constexpr std::size_t Size = sizeof...(Args);
+  template <std::size_t Index>
+  using At = typename FunctionTypeElement<Index, Args...>::Type;
+  template <template <typename...> class Target>
+  using Apply = Target<Args...>;
+};
+
+template <typename ...Args>
+constexpr std::size_t FunctionTypeList<Args...>::Size;
+
 template <class Return, typename ...Args>
 struct FunctionTypeSupported
 {
   using Type = Return(Args...);
+#if !defined(FUNCTION_TYPE_NO_TUPLE)
   using ArgumentsType = std::tuple<Args...>;
+#endif // !FUNCTION_TYPE_NO_TUPLE
+  using ArgumentList = FunctionTypeList<Args...>;
   using ReturnType = Return;
+  static constexpr std::size_t Arity = sizeof...(Args);
+  template <std::size_t Index>
+  using Arg = typename FunctionTypeElement<Index, Args...>::Type;
+};
+
+template <class Return, typename ...Args>
+constexpr std::size_t FunctionTypeSupported<Return, Args...>::Arity;
+
+// Qualifier and class metadata
+
+enum class FunctionTypeReference
+{
+  None,
+  LValue,
+  RValue
+};
+
+template <class Class, bool Const, bool Volatile, FunctionTypeReference Reference, bool Noexcept>
+struct FunctionTypeQualifiers
+{
+  using ClassType = Class;  // void for free functions
+  static constexpr bool IsMember = !std::is_void<Class>::value;
+  static constexpr bool IsConst = Const;
+  static constexpr bool IsVolatile = Volatile;
+  static constexpr FunctionTypeReference RefQualifier = Reference;
+  static constexpr bool IsNoexcept = Noexcept;
 };
 
+template <class Class, bool Const, bool Volatile, FunctionTypeReference Reference, bool Noexcept>
+constexpr bool FunctionTypeQualifiers<Class, Const, Volatile, Reference, Noexcept>::IsMember;
+template <class Class, bool Const, bool Volatile, FunctionTypeReference Reference, bool Noexcept>
+constexpr bool FunctionTypeQualifiers<Class, Const, Volatile, Reference, Noexcept>::IsConst;
+template <class Class, bool Const, bool Volatile, FunctionTypeReference Reference, bool Noexcept>
+constexpr bool FunctionTypeQualifiers<Class, Const, Volatile, Reference, Noexcept>::IsVolatile;
+template <class Class, bool Const, bool Volatile, FunctionTypeReference Reference, bool Noexcept>
+constexpr FunctionTypeReference FunctionTypeQualifiers<Class, Const, Volatile, Reference, Noexcept>::RefQualifier;
+template <class Class, bool Const, bool Volatile, FunctionTypeReference Reference, bool Noexcept>
+constexpr bool FunctionTypeQualifiers<Class, Const, Volatile, Reference, Noexcept>::IsNoexcept;
+
 template <class Return>
 struct FunctionTypeUnsupported
 {
   using Type = std::nullptr_t;
+#if !defined(FUNCTION_TYPE_NO_TUPLE)
   using ArgumentsType = std::nullptr_t;
+#endif // !FUNCTION_TYPE_NO_TUPLE
+  using ArgumentList = std::nullptr_t;
   using ReturnType = std::nullptr_t;
   static_assert(AlwaysFalse<Return>, "FunctionType does not support non-template (C-style) variadic functions.");
 };
 
+// Signature fingerprints. Types are hashed structurally: integers by
+// signedness and size, character and floating point types by kind and size,
+// compounds by their parts. Class and enum types are hashed by name, from
+// FunctionTypeName when it is specialized (see FUNCTION_TYPE_NAME) and from
+// the compiler's spelling of the type otherwise, with keywords and spaces
+// removed. Spellings agree across translation units, and for plain names
+// across compilers; specialize FunctionTypeName for class types whose
+// fingerprints must match across compilers or standard libraries.
+
+template <class T>
+struct FunctionTypeName
+{
+  static constexpr const char* value = nullptr;
+};
+
+#define FUNCTION_TYPE_NAME(...) template <>\
+struct FunctionTypeName<__VA_ARGS__> { static constexpr const char* value = #__VA_ARGS__; };
+
+constexpr std::uint64_t FunctionTypeHashBasis = 0xCBF29CE484222325ull;
+
+constexpr std::uint64_t FunctionTypeHashByte(std::uint64_t hash, unsigned char byte)
+{
+  return (hash ^ byte) * 0x100000001B3ull;
+}
+
+constexpr std::uint64_t FunctionTypeHashValue(std::uint64_t hash, std::uint64_t value)
+{
+  for (int i = 0; i < 8; ++i, value >>= 8)
+    hash = FunctionTypeHashByte(hash, static_cast<unsigned char>(value & 0xFF));
+  return hash;
+}
+
+constexpr bool FunctionTypeIsKeyword(const char* text, const char* keyword)
+{
+  for (; *keyword != '\0'; ++text, ++keyword)
+    if (*text != *keyword)
+      return false;
+  return *text == ' ';
+}
+
+// Hashes a type's spelling up to the end of the template argument, skipping
+// spaces and the struct, class, enum and union keywords
+constexpr std::uint64_t FunctionTypeHashSpelling(std::uint64_t hash, const char* text, char terminator, char separator)
+{
+  int depth = 0;
+  bool token = true;
+  for (; *text != '\0'; ++text)
+  {
+    const char character = *text;
+    if (depth == 0 && (character == terminator || character == separator))
+      break;
+    if (character == '<' || character == '(' || character == '[')
+      ++depth;
+    else if (character == '>' || character == ')' || character == ']')
+      --depth;
+    if (token && (FunctionTypeIsKeyword(text, "struct") || FunctionTypeIsKeyword(text, "class") ||
+      FunctionTypeIsKeyword(text, "enum") || FunctionTypeIsKeyword(text, "union")))
+    {
+      while (*text != ' ')
+        ++text;
+      continue;
+    }
+    token = !((character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z') || (character >= '0' && character <= '9') || character == '_');
+    if (character != ' ')
+      hash = FunctionTypeHashByte(hash, static_cast<unsigned char>(character));
+  }
+  return FunctionTypeHashByte(hash, 0);
+}
+
+constexpr const char* FunctionTypeFind(const char* text, const char* pattern)
+{
+  for (; *text != '\0'; ++text)
+  {
+    std::size_t i = 0;
+    while (pattern[i] != '\0' && text[i] == pattern[i])
+      ++i;
+    if (pattern[i] == '\0')
+      return text + i;
+  }
+  return text;
+}
+
+template <class T>
+constexpr std::uint64_t FunctionTypeHashCompilerName(std::uint64_t hash)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+  // "... FunctionTypeHashCompilerName<struct Name>(unsigned __int64)"
+  return FunctionTypeHashSpelling(hash, FunctionTypeFind(__FUNCSIG__, "FunctionTypeHashCompilerName<"), '>', '>');
+#else
+  // "... [with T = Name; ...]" (GCC) or "... [T = Name]" (Clang)
+  return FunctionTypeHashSpelling(hash, FunctionTypeFind(__PRETTY_FUNCTION__, "T = "), ']', ';');
+#endif // _MSC_VER
+}
+
+template <class T>
+struct FunctionTypeHasher
+{
+  static constexpr std::uint64_t Apply(std::uint64_t hash)
+  {
+    using Bare = std::remove_cv_t<T>;
+    // Only arithmetic types are sized, others may be void or incomplete
+    using Sized = std::conditional_t<std::is_arithmetic<Bare>::value, Bare, char>;
+    if (FunctionTypeName<T>::value != nullptr)
+    {
+      const char* name = FunctionTypeName<T>::value;
+      hash = FunctionTypeHashByte(hash, 'N');
+      for (; *name != '\0'; ++name)
+        if (*name != ' ')
+          hash = FunctionTypeHashByte(hash, static_cast<unsigned char>(*name));
+      return FunctionTypeHashByte(hash, 0);
+    }
+    if (std::is_void<Bare>::value)
+      return FunctionTypeHashByte(hash, 'v');
+    if (std::is_null_pointer<Bare>::value)
+      return FunctionTypeHashByte(hash, 'n');
+    if (std::is_same<Bare, bool>::value)
+      return FunctionTypeHashByte(hash, 'b');
+    if (std::is_same<Bare, char>::value)
+      return FunctionTypeHashByte(hash, 'c');
+    if (std::is_same<Bare, wchar_t>::value || std::is_same<Bare, char16_t>::value || std::is_same<Bare, char32_t>::value
+#if defined(__cpp_char8_t)
+      || std::is_same<Bare, char8_t>::value
+#endif // __cpp_char8_t
+      )
+      return FunctionTypeHashValue(FunctionTypeHashByte(hash, std::is_same<Bare, wchar_t>::value ? 'w' : 'u'), sizeof(Sized));
+    if (std::is_integral<Bare>::value)
+      return FunctionTypeHashValue(FunctionTypeHashByte(hash, std::is_signed<Bare>::value ? 'i' : 'j'), sizeof(Sized));
+    if (std::is_floating_point<Bare>::value)
+      return FunctionTypeHashValue(FunctionTypeHashByte(hash, 'f'), sizeof(Sized));
+    return FunctionTypeHashCompilerName<T>(FunctionTypeHashByte(hash, 'N'));
+  }
+};
+
+template <class T>
+struct FunctionTypeHasher<const T>
+{
+  static constexpr std::uint64_t Apply(std::uint64_t hash) { return FunctionTypeHashByte(FunctionTypeHasher<T>::Apply(hash), 'K'); }
+};
+
+template <class T>
+struct FunctionTypeHasher<volatile T>
+{
+  static constexpr std::uint64_t Apply(std::uint64_t hash) { return FunctionTypeHashByte(FunctionTypeHasher<T>::Apply(hash), 'V'); }
+};
+
+template <class T>
+struct FunctionTypeHasher<const volatile T>
+{
+  static constexpr std::uint64_t Apply(std::uint64_t hash) { return FunctionTypeHashByte(FunctionTypeHashByte(FunctionTypeHasher<T>::Apply(hash), 'K'), 'V'); }
+};
+
+template <class T>
+struct FunctionTypeHasher<T*>
+{
+  static constexpr std::uint64_t Apply(std::uint64_t hash) { return FunctionTypeHashByte(FunctionTypeHasher<T>::Apply(hash), 'P'); }
+};
+
+template <class T>
+struct FunctionTypeHasher<T&>
+{
+  static constexpr std::uint64_t Apply(std::uint64_t hash) { return FunctionTypeHashByte(FunctionTypeHasher<T>::Apply(hash), 'R'); }
+};
+
+template <class T>
+struct FunctionTypeHasher<T&&>
+{
+  static constexpr std::uint64_t Apply(std::uint64_t hash) { return FunctionTypeHashByte(FunctionTypeHasher<T>::Apply(hash), 'O'); }
+};
+
+template <class T>
+struct FunctionTypeHasher<T[]>
+{
+  static constexpr std::uint64_t Apply(std::uint64_t hash) { return FunctionTypeHashByte(FunctionTypeHasher<T>::Apply(hash), 'A'); }
+};
+
+template <class T, std::size_t Size>
+struct FunctionTypeHasher<T[Size]>
+{
+  static constexpr std::uint64_t Apply(std::uint64_t hash) { return FunctionTypeHashValue(FunctionTypeHashByte(FunctionTypeHasher<T>::Apply(hash), 'A'), Size); }
+};
+
+template <class T, class Class>
+struct FunctionTypeHasher<T Class::*>
+{
+  static constexpr std::uint64_t Apply(std::uint64_t hash) { return FunctionTypeHashByte(FunctionTypeHasher<T>::Apply(FunctionTypeHasher<Class>::Apply(hash)), 'M'); }
+};
+
+template <class Return, typename ...Args>
+struct FunctionTypeHasher<Return(Args...)>
+{
+  static constexpr std::uint64_t Apply(std::uint64_t hash)
+  {
+    hash = FunctionTypeHashByte(FunctionTypeHasher<Return>::Apply(hash), '(');
+    const std::uint64_t ignored[] = { 0, (hash = FunctionTypeHasher<Args>::Apply(hash))... };
+    static_cast<void>(ignored);
+    return FunctionTypeHashByte(hash, ')');
+  }
+};
+
+#if !defined(FUNCTION_TYPE_CPP14)
+template <class Return, typename ...Args>
+struct FunctionTypeHasher<Return(Args...) noexcept>
+{
+  static constexpr std::uint64_t Apply(std::uint64_t hash) { return FunctionTypeHashByte(FunctionTypeHasher<Return(Args...)>::Apply(hash), 'X'); }
+};
+#endif // !FUNCTION_TYPE_CPP14
+
+// Return and argument types, then the class and qualifiers of member functions
+template <class Signature, class Qualifiers>
+constexpr std::uint64_t FunctionTypeFingerprint()
+{
+  std::uint64_t hash = FunctionTypeHasher<Signature>::Apply(FunctionTypeHashBasis);
+  hash = FunctionTypeHasher<typename Qualifiers::ClassType>::Apply(hash);
+  hash = FunctionTypeHashByte(hash, static_cast<unsigned char>((Qualifiers::IsConst ? 1 : 0) | (Qualifiers::IsVolatile ? 2 : 0) |
+    (static_cast<int>(Qualifiers::RefQualifier) << 2) | (Qualifiers::IsNoexcept ? 16 : 0)));
+  // Finalizer, so fingerprints of similar signatures differ in every bit position
+  hash = (hash ^ (hash >> 33)) * 0xFF51AFD7ED558CCDull;
+  hash = (hash ^ (hash >> 33)) * 0xC4CEB9FE1A85EC53ull;
+  return hash ^ (hash >> 33);
+}
+
 // Lambda pass-through
 
 template <class Lambda>
-struct FunctionType
+struct FunctionType : public FunctionType<decltype(&Lambda::operator())>
 {
   using LambdaType = decltype(&Lambda::operator());
-  using Type = typename FunctionType<LambdaType>::Type;
-  using ArgumentsType = typename FunctionType<LambdaType>::ArgumentsType;
-  using ReturnType = typename FunctionType<LambdaType>::ReturnType;
+
+  // A callable object describes its call signature like a function pointer:
+  // the call operator's class and qualifiers are not reported, noexcept is
+  using ClassType = void;
+  static constexpr bool IsMember = false;
+  static constexpr bool IsConst = false;
+  static constexpr bool IsVolatile = false;
+  static constexpr FunctionTypeReference RefQualifier = FunctionTypeReference::None;
+
+  static constexpr std::uint64_t Fingerprint() { return FunctionTypeFingerprint<typename FunctionType::Type, FunctionType>(); }
 };
 
-#define FUNCTION_TYPE_BOILERPLATE(...) template <class Return, typename ...Args>\
-struct FunctionType <Return(*)(Args...)__VA_ARGS__> : public FunctionTypeSupported<Return, Args...> {};
-#define FUNCTION_TYPE_CLASS_BOILERPLATE(...) template <class Return, class Class, typename ...Args>\
-struct FunctionType <Return(Class::*)(Args...)__VA_ARGS__> : public FunctionTypeSupported<Return, Args...> {};
+template <class Lambda>
+constexpr bool FunctionType<Lambda>::IsMember;
+template <class Lambda>
+constexpr bool FunctionType<Lambda>::IsConst;
+template <class Lambda>
+constexpr bool FunctionType<Lambda>::IsVolatile;
+template <class Lambda>
+constexpr FunctionTypeReference FunctionType<Lambda>::RefQualifier;
+
+#define FUNCTION_TYPE_BOILERPLATE(Qualifiers, Noexcept) template <class Return, typename ...Args>\
+struct FunctionType <Return(*)(Args...)Qualifiers> : public FunctionTypeSupported<Return, Args...>,\
+  public FunctionTypeQualifiers<void, false, false, FunctionTypeReference::None, Noexcept>\
+{\
+  static constexpr std::uint64_t Fingerprint() { return FunctionTypeFingerprint<Return(Args...), FunctionType>(); }\
+};
+#define FUNCTION_TYPE_CLASS_BOILERPLATE(Qualifiers, Const, Volatile, Reference, Noexcept) template <class Return, class Class, typename ...Args>\
+struct FunctionType <Return(Class::*)(Args...)Qualifiers> : public FunctionTypeSupported<Return, Args...>,\
+  public FunctionTypeQualifiers<Class, Const, Volatile, FunctionTypeReference::Reference, Noexcept>\
+{\
+  static constexpr std::uint64_t Fingerprint() { return FunctionTypeFingerprint<Return(Args...), FunctionType>(); }\
+};
 #define FUNCTION_TYPE_CLASS_UNSUPPORTED_BOILERPLATE(...) template <class Return, class Class>\
 struct FunctionType <Return(Class::*)(...)__VA_ARGS__> : public FunctionTypeUnsupported<Return> {};
 #define FUNCTION_TYPE_UNSUPPORTED_BOILERPLATE(...) template <class Return>\
@@ -70,34 +421,34 @@ struct FunctionType <Return(*)(...)__VA_ARGS__> : public FunctionTypeUnsupported
 
 // Supported types
 
-FUNCTION_TYPE_CLASS_BOILERPLATE();
-FUNCTION_TYPE_CLASS_BOILERPLATE(const);
-FUNCTION_TYPE_CLASS_BOILERPLATE(volatile);
-FUNCTION_TYPE_CLASS_BOILERPLATE(const volatile);
-FUNCTION_TYPE_CLASS_BOILERPLATE(&);
-FUNCTION_TYPE_CLASS_BOILERPLATE(const&);
-FUNCTION_TYPE_CLASS_BOILERPLATE(volatile&);
-FUNCTION_TYPE_CLASS_BOILERPLATE(const volatile&);
-FUNCTION_TYPE_CLASS_BOILERPLATE(&&);
-FUNCTION_TYPE_CLASS_BOILERPLATE(const&&);
-FUNCTION_TYPE_CLASS_BOILERPLATE(volatile&&);
-FUNCTION_TYPE_CLASS_BOILERPLATE(const volatile&&);
-FUNCTION_TYPE_BOILERPLATE();
+FUNCTION_TYPE_CLASS_BOILERPLATE(, false, false, None, false);
+FUNCTION_TYPE_CLASS_BOILERPLATE(const, true, false, None, false);
+FUNCTION_TYPE_CLASS_BOILERPLATE(volatile, false, true, None, false);
+FUNCTION_TYPE_CLASS_BOILERPLATE(const volatile, true, true, None, false);
+FUNCTION_TYPE_CLASS_BOILERPLATE(&, false, false, LValue, false);
+FUNCTION_TYPE_CLASS_BOILERPLATE(const&, true, false, LValue, false);
+FUNCTION_TYPE_CLASS_BOILERPLATE(volatile&, false, true, LValue, false);
+FUNCTION_TYPE_CLASS_BOILERPLATE(const volatile&, true, true, LValue, false);
+FUNCTION_TYPE_CLASS_BOILERPLATE(&&, false, false, RValue, false);
+FUNCTION_TYPE_CLASS_BOILERPLATE(const&&, true, false, RValue, false);
+FUNCTION_TYPE_CLASS_BOILERPLATE(volatile&&, false, true, RValue, false);
+FUNCTION_TYPE_CLASS_BOILERPLATE(const volatile&&, true, true, RValue, false);
+FUNCTION_TYPE_BOILERPLATE(, false);
 
 #if !defined(FUNCTION_TYPE_CPP14)
-FUNCTION_TYPE_CLASS_BOILERPLATE(noexcept);
-FUNCTION_TYPE_CLASS_BOILERPLATE(const noexcept);
-FUNCTION_TYPE_CLASS_BOILERPLATE(volatile noexcept);
-FUNCTION_TYPE_CLASS_BOILERPLATE(const volatile noexcept);
-FUNCTION_TYPE_CLASS_BOILERPLATE(&noexcept);
-FUNCTION_TYPE_CLASS_BOILERPLATE(const& noexcept);
-FUNCTION_TYPE_CLASS_BOILERPLATE(volatile& noexcept);
-FUNCTION_TYPE_CLASS_BOILERPLATE(const volatile& noexcept);
-FUNCTION_TYPE_CLASS_BOILERPLATE(&& noexcept);
-FUNCTION_TYPE_CLASS_BOILERPLATE(const&& noexcept);
-FUNCTION_TYPE_CLASS_BOILERPLATE(volatile&& noexcept);
-FUNCTION_TYPE_CLASS_BOILERPLATE(const volatile&& noexcept);
-FUNCTION_TYPE_BOILERPLATE(noexcept);
+FUNCTION_TYPE_CLASS_BOILERPLATE(noexcept, false, false, None, true);
+FUNCTION_TYPE_CLASS_BOILERPLATE(const noexcept, true, false, None, true);
+FUNCTION_TYPE_CLASS_BOILERPLATE(volatile noexcept, false, true, None, true);
+FUNCTION_TYPE_CLASS_BOILERPLATE(const volatile noexcept, true, true, None, true);
+FUNCTION_TYPE_CLASS_BOILERPLATE(&noexcept, false, false, LValue, true);
+FUNCTION_TYPE_CLASS_BOILERPLATE(const& noexcept, true, false, LValue, true);
+FUNCTION_TYPE_CLASS_BOILERPLATE(volatile& noexcept, false, true, LValue, true);
+FUNCTION_TYPE_CLASS_BOILERPLATE(const volatile& noexcept, true, true, LValue, true);
+FUNCTION_TYPE_CLASS_BOILERPLATE(&& noexcept, false, false, RValue, true);
+FUNCTION_TYPE_CLASS_BOILERPLATE(const&& noexcept, true, false, RValue, true);
+FUNCTION_TYPE_CLASS_BOILERPLATE(volatile&& noexcept, false, true, RValue, true);
+FUNCTION_TYPE_CLASS_BOILERPLATE(const volatile&& noexcept, true, true, RValue, true);
+FUNCTION_TYPE_BOILERPLATE(noexcept, true);
 #endif // !FUNCTION_TYPE_CPP14
 
 // Unsupported types
@@ -137,4 +488,24 @@ FUNCTION_TYPE_UNSUPPORTED_BOILERPLATE(noexcept);
 #undef FUNCTION_TYPE_CLASS_UNSUPPORTED_BOILERPLATE
 #undef FUNCTION_TYPE_UNSUPPORTED_BOILERPLATE
 
+// A decayed signature with noexcept added back, for wrappers that deduce
+// their signature and must keep a noexcept callable's noexcept
+
+template <class Signature, bool Noexcept>
+struct FunctionTypeSignature
+{
+  using Type = Signature;
+};
+
+#if !defined(FUNCTION_TYPE_CPP14)
+template <class Return, typename ...Args>
+struct FunctionTypeSignature<Return(Args...), true>
+{
+  using Type = Return(Args...) noexcept;
+};
+#endif // !FUNCTION_TYPE_CPP14
+
+template <class Function>
+using FunctionTypeExactSignature = typename FunctionTypeSignature<typename FunctionType<Function>::Type, FunctionType<Function>::IsNoexcept>::Type;
+
 #endif // FUNCTION_TYPE
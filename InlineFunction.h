@@ -0,0 +1,278 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef INLINE_FUNCTION
+#define INLINE_FUNCTION
+#pragma once
+
+#include "FunctionType.h"
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Default small-buffer size, large enough for a member pointer bound to an object
+#if !defined(INLINE_FUNCTION_CAPACITY)
+#define INLINE_FUNCTION_CAPACITY (4 * sizeof(void*))
+#endif // !INLINE_FUNCTION_CAPACITY
+
+// Type-erased callable storage that never allocates. Callables that do not fit
+// into Capacity bytes are rejected at compile time.
+
+enum class InlineFunctionOperation
+{
+  Copy,
+  Move,
+  Destroy
+};
+
+template <class Callable, bool Copyable>
+struct InlineFunctionCopier
+{
+  static void Copy(void* target, const void* source) { ::new (target) Callable(*static_cast<const Callable*>(source)); }
+};
+
+template <class Callable>
+struct InlineFunctionCopier<Callable, false>
+{
+  static void Copy(void*, const void*) {}
+};
+
+template <class Callable, bool Copyable>
+void InlineFunctionManage(InlineFunctionOperation operation, void* target, void* source)
+{
+  switch (operation)
+  {
+  case InlineFunctionOperation::Copy:
+    InlineFunctionCopier<Callable, Copyable>::Copy(target, source);
+    break;
+  case InlineFunctionOperation::Move:
+    ::new (target) Callable(std::move(*static_cast<Callable*>(source)));
+    static_cast<Callable*>(source)->~Callable();
+    break;
+  case InlineFunctionOperation::Destroy:
+    static_cast<Callable*>(target)->~Callable();
+    break;
+  }
+}
+
+template <std::size_t Capacity, bool Copyable, bool Noexcept, class Return, typename ...Args>
+class InlineFunctionStorage
+{
+public:
+  using Type = Return(Args...);
+  static constexpr std::size_t StorageCapacity = Capacity;
+
+  InlineFunctionStorage() noexcept = default;
+  InlineFunctionStorage(std::nullptr_t) noexcept {}
+
+  template <class Callable, typename = std::enable_if_t<!std::is_base_of<InlineFunctionStorage, std::decay_t<Callable>>::value &&
+    !std::is_same<std::decay_t<Callable>, std::nullptr_t>::value>>
+  InlineFunctionStorage(Callable&& callable)
+  {
+    using Stored = std::decay_t<Callable>;
+    static_assert(sizeof(Stored) <= Capacity, "InlineFunction capacity is too small for this callable.");
+    static_assert(alignof(Stored) <= alignof(std::max_align_t), "InlineFunction does not support over-aligned callables.");
+    static_assert(std::is_nothrow_move_constructible<Stored>::value, "InlineFunction requires a nothrow move constructible callable.");
+    static_assert(!Copyable || std::is_copy_constructible<Stored>::value, "InlineFunction requires a copy constructible callable, use MoveOnlyInlineFunction instead.");
+    static_assert(std::is_convertible<decltype(std::declval<Stored&>()(std::declval<Args>()...)), Return>::value || std::is_void<Return>::value,
+      "InlineFunction callable is not invocable with the requested signature.");
+    static_assert(!Noexcept || noexcept(std::declval<Stored&>()(std::declval<Args>()...)), "InlineFunction noexcept signature requires a noexcept callable.");
+    ::new (static_cast<void*>(storage_)) Stored(std::forward<Callable>(callable));
+    // Trivial callables are copied as the whole buffer, so its tail is initialized too
+    if (std::is_trivially_copyable<Stored>::value && std::is_trivially_destructible<Stored>::value && sizeof(Stored) < Capacity)
+      std::memset(storage_ + sizeof(Stored), 0, Capacity - sizeof(Stored));
+    invoke_ = &Invoke<Stored>;
+    // Trivial callables are copied and moved as raw bytes, without a manager call
+    manage_ = std::is_trivially_copyable<Stored>::value && std::is_trivially_destructible<Stored>::value ?
+      nullptr : &InlineFunctionManage<Stored, Copyable>;
+  }
+
+  InlineFunctionStorage(const InlineFunctionStorage& other)
+    : invoke_(other.invoke_), manage_(other.manage_)
+  {
+    Transfer(InlineFunctionOperation::Copy, const_cast<InlineFunctionStorage&>(other));
+  }
+
+  InlineFunctionStorage(InlineFunctionStorage&& other) noexcept
+    : invoke_(other.invoke_), manage_(other.manage_)
+  {
+    Transfer(InlineFunctionOperation::Move, other);
+    other.invoke_ = nullptr;
+    other.manage_ = nullptr;
+  }
+
+  InlineFunctionStorage& operator=(const InlineFunctionStorage& other)
+  {
+    if (this != &other)
+    {
+      InlineFunctionStorage copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  InlineFunctionStorage& operator=(InlineFunctionStorage&& other) noexcept
+  {
+    if (this != &other)
+    {
+      Reset();
+      invoke_ = other.invoke_;
+      manage_ = other.manage_;
+      Transfer(InlineFunctionOperation::Move, other);
+      other.invoke_ = nullptr;
+      other.manage_ = nullptr;
+    }
+    return *this;
+  }
+
+  InlineFunctionStorage& operator=(std::nullptr_t) noexcept
+  {
+    Reset();
+    return *this;
+  }
+
+  ~InlineFunctionStorage() { Reset(); }
+
+  Return operator()(Args... args) const noexcept(Noexcept)
+  {
+    assert(invoke_ && "InlineFunction called while empty.");
+    return invoke_(storage_, std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const noexcept { return invoke_ != nullptr; }
+
+private:
+  using InvokeType = Return(*)(void*, Args&&...);
+  using ManageType = void(*)(InlineFunctionOperation, void*, void*);
+
+  template <class Stored>
+  static Return Invoke(void* storage, Args&&... args) noexcept(Noexcept)
+  {
+    return static_cast<Return>((*static_cast<Stored*>(storage))(std::forward<Args>(args)...));
+  }
+
+  void Transfer(InlineFunctionOperation operation, InlineFunctionStorage& other)
+  {
+    if (manage_)
+      manage_(operation, storage_, other.storage_);
+    else if (invoke_)
+      std::memcpy(storage_, other.storage_, Capacity);
+  }
+
+  void Reset() noexcept
+  {
+    if (manage_)
+      manage_(InlineFunctionOperation::Destroy, storage_, nullptr);
+    invoke_ = nullptr;
+    manage_ = nullptr;
+  }
+
+  alignas(std::max_align_t) mutable unsigned char storage_[Capacity];
+  InvokeType invoke_ = nullptr;
+  ManageType manage_ = nullptr;
+};
+
+template <std::size_t Capacity, bool Copyable, bool Noexcept, class Return, typename ...Args>
+constexpr std::size_t InlineFunctionStorage<Capacity, Copyable, Noexcept, Return, Args...>::StorageCapacity;
+
+// Deletes the copy operations of move-only instantiations
+
+template <bool Copyable>
+struct InlineFunctionCopyPolicy {};
+
+template <>
+struct InlineFunctionCopyPolicy<false>
+{
+  InlineFunctionCopyPolicy() = default;
+  InlineFunctionCopyPolicy(const InlineFunctionCopyPolicy&) = delete;
+  InlineFunctionCopyPolicy(InlineFunctionCopyPolicy&&) = default;
+  InlineFunctionCopyPolicy& operator=(const InlineFunctionCopyPolicy&) = delete;
+  InlineFunctionCopyPolicy& operator=(InlineFunctionCopyPolicy&&) = default;
+};
+
+// Public interface
+
+template <class Signature, std::size_t Capacity = INLINE_FUNCTION_CAPACITY, bool Copyable = true>
+class InlineFunction
+{
+  static_assert(AlwaysFalse<Signature>, "InlineFunction requires a function type signature.");
+};
+
+template <class Return, typename ...Args, std::size_t Capacity, bool Copyable>
+class InlineFunction<Return(Args...), Capacity, Copyable>
+  : public InlineFunctionStorage<Capacity, Copyable, false, Return, Args...>, private InlineFunctionCopyPolicy<Copyable>
+{
+public:
+  using InlineFunctionStorage<Capacity, Copyable, false, Return, Args...>::InlineFunctionStorage;
+  InlineFunction() noexcept = default;
+};
+
+#if !defined(FUNCTION_TYPE_CPP14)
+template <class Return, typename ...Args, std::size_t Capacity, bool Copyable>
+class InlineFunction<Return(Args...) noexcept, Capacity, Copyable>
+  : public InlineFunctionStorage<Capacity, Copyable, true, Return, Args...>, private InlineFunctionCopyPolicy<Copyable>
+{
+public:
+  using InlineFunctionStorage<Capacity, Copyable, true, Return, Args...>::InlineFunctionStorage;
+  InlineFunction() noexcept = default;
+};
+#endif // !FUNCTION_TYPE_CPP14
+
+template <class Signature, std::size_t Capacity = INLINE_FUNCTION_CAPACITY>
+using MoveOnlyInlineFunction = InlineFunction<Signature, Capacity, false>;
+
+// Member function pointer bound to an object, invoked as an lvalue
+
+template <class Object, class Method, class Signature = typename FunctionType<Method>::Type>
+struct InlineFunctionBound;
+
+template <class Object, class Method, class Return, typename ...Args>
+struct InlineFunctionBound<Object, Method, Return(Args...)>
+{
+  Object* object;
+  Method method;
+
+  Return operator()(Args... args) const noexcept(FunctionType<Method>::IsNoexcept) { return (object->*method)(std::forward<Args>(args)...); }
+};
+
+// Signature deduction, noexcept callables give a noexcept signature
+
+template <std::size_t Capacity = INLINE_FUNCTION_CAPACITY, class Callable>
+InlineFunction<FunctionTypeExactSignature<std::decay_t<Callable>>, Capacity, std::is_copy_constructible<std::decay_t<Callable>>::value>
+MakeDelegate(Callable&& callable)
+{
+  return { std::forward<Callable>(callable) };
+}
+
+template <std::size_t Capacity = INLINE_FUNCTION_CAPACITY, class Object, class Method,
+  typename = std::enable_if_t<std::is_member_function_pointer<Method>::value>>
+InlineFunction<FunctionTypeExactSignature<Method>, Capacity>
+MakeDelegate(Object& object, Method method)
+{
+  return { InlineFunctionBound<Object, Method>{ &object, method } };
+}
+
+#endif // INLINE_FUNCTION
@@ -0,0 +1,446 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef INSTRUMENT
+#define INSTRUMENT
+#pragma once
+
+// Requires ISO C++17 (inline variables, if constexpr)
+
+// Define INSTRUMENT_DISABLED to compile instrumentation away: Instrument then
+// returns the callable itself, and the aggregator and snapshots do nothing.
+
+#include "FunctionType.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if !defined(INSTRUMENT_DISABLED)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif // _MSC_VER
+#endif // !INSTRUMENT_DISABLED
+
+// Latency summary of one instrumented call site, merged across threads
+
+struct InstrumentStatistics
+{
+  std::string name;
+  std::uint64_t calls = 0;
+  std::uint64_t samples = 0;  // timed calls, the latencies below describe these
+  double mean = 0.0;          // nanoseconds
+  double p50 = 0.0;
+  double p90 = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+};
+
+#if !defined(INSTRUMENT_DISABLED)
+
+// Time stamp counter where available (assumed invariant, as on current x86
+// processors), the steady clock otherwise. Ticks are converted to nanoseconds
+// only when a snapshot is taken.
+
+struct InstrumentClock
+{
+  static std::uint64_t Now() noexcept
+  {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif // x86
+  }
+};
+
+// Log-linear histogram of ticks, 16 linear sub-buckets per power of two,
+// so a bucket's bounds are within 6.25% of each other
+
+struct InstrumentHistogram
+{
+  static constexpr std::size_t SubBuckets = 16;
+  static constexpr std::size_t Size = (64 - 3) * SubBuckets;
+
+  static std::size_t Bucket(std::uint64_t ticks) noexcept
+  {
+    if (ticks < SubBuckets)
+      return static_cast<std::size_t>(ticks);
+#if defined(_MSC_VER)
+    unsigned long exponent;
+    _BitScanReverse64(&exponent, ticks);
+#else
+    const unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(ticks));
+#endif // _MSC_VER
+    return (exponent - 3) * SubBuckets + static_cast<std::size_t>((ticks >> (exponent - 4)) & (SubBuckets - 1));
+  }
+
+  // Midpoint of a bucket's range
+  static double Value(std::size_t bucket) noexcept
+  {
+    if (bucket < SubBuckets)
+      return static_cast<double>(bucket);
+    const std::size_t shift = bucket / SubBuckets - 1;
+    const double lower = static_cast<double>((SubBuckets + bucket % SubBuckets) << shift);
+    return lower + static_cast<double>(std::uint64_t(1) << shift) / 2;
+  }
+};
+
+// Counters of one call site on one thread. Only the owning thread writes
+// them, with plain relaxed stores, the aggregator reads them concurrently.
+
+struct InstrumentCounters
+{
+  std::atomic<std::uint64_t> calls{ 0 };
+  std::atomic<std::uint64_t> samples{ 0 };
+  std::atomic<std::uint64_t> ticks{ 0 };
+  std::atomic<std::uint64_t> max{ 0 };
+  std::atomic<std::uint64_t> buckets[InstrumentHistogram::Size] = {};
+
+  static void Add(std::atomic<std::uint64_t>& counter, std::uint64_t value) noexcept
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  // Counts the call, returns its number on this thread
+  std::uint64_t Count() noexcept
+  {
+    const std::uint64_t count = calls.load(std::memory_order_relaxed);
+    calls.store(count + 1, std::memory_order_relaxed);
+    return count;
+  }
+
+  void Record(std::uint64_t elapsed) noexcept
+  {
+    Add(samples, 1);
+    Add(ticks, elapsed);
+    Add(buckets[InstrumentHistogram::Bucket(elapsed)], 1);
+    if (elapsed > max.load(std::memory_order_relaxed))
+      max.store(elapsed, std::memory_order_relaxed);
+  }
+
+  void Merge(const InstrumentCounters& other) noexcept
+  {
+    Add(calls, other.calls.load(std::memory_order_relaxed));
+    Add(samples, other.samples.load(std::memory_order_relaxed));
+    Add(ticks, other.ticks.load(std::memory_order_relaxed));
+    for (std::size_t i = 0; i < InstrumentHistogram::Size; ++i)
+      Add(buckets[i], other.buckets[i].load(std::memory_order_relaxed));
+    if (other.max.load(std::memory_order_relaxed) > max.load(std::memory_order_relaxed))
+      max.store(other.max.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+};
+
+class InstrumentThread;
+
+// Call site names and the counters of every live thread. Counters of exited
+// threads are merged into the retired totals, so no calls are lost.
+
+class InstrumentRegistry
+{
+public:
+  static InstrumentRegistry& Instance()
+  {
+    static InstrumentRegistry registry;
+    return registry;
+  }
+
+  // Call sites with the same name share their counters
+  std::size_t Register(const std::string& name)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < names_.size(); ++i)
+      if (names_[i] == name)
+        return i;
+    names_.push_back(name);
+    retired_.push_back(std::make_unique<InstrumentCounters>());
+    return names_.size() - 1;
+  }
+
+  std::vector<InstrumentStatistics> Snapshot();
+
+private:
+  friend class InstrumentThread;
+
+  InstrumentRegistry()
+    : origin_(std::chrono::steady_clock::now()), origin_ticks_(InstrumentClock::Now()) {}
+
+  double NanosecondsPerTick() const
+  {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now - origin_ < std::chrono::milliseconds(1))
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      now = std::chrono::steady_clock::now();
+    }
+    const std::uint64_t ticks = InstrumentClock::Now() - origin_ticks_;
+    return std::chrono::duration<double, std::nano>(now - origin_).count() / static_cast<double>(ticks);
+#else
+    return 1.0;
+#endif // x86
+  }
+
+  std::mutex mutex_;
+  std::vector<std::string> names_;
+  std::vector<std::unique_ptr<InstrumentCounters>> retired_;
+  std::vector<InstrumentThread*> threads_;
+  std::chrono::steady_clock::time_point origin_;
+  std::uint64_t origin_ticks_;
+};
+
+// Per-thread counters, indexed by call site. Grown under the registry lock,
+// read without it by the owning thread.
+
+class InstrumentThread
+{
+public:
+  static InstrumentCounters& Counters(std::size_t site)
+  {
+    static thread_local InstrumentThread* current = nullptr;
+    if (current != nullptr && site < current->sites_.size() && current->sites_[site] != nullptr)
+      return *current->sites_[site];
+    if (current == nullptr)
+    {
+      static thread_local InstrumentThread thread;
+      current = &thread;
+    }
+    return current->Grow(site);
+  }
+
+  ~InstrumentThread()
+  {
+    std::lock_guard<std::mutex> lock(registry_.mutex_);
+    for (std::size_t i = 0; i < sites_.size(); ++i)
+      if (sites_[i] != nullptr)
+        registry_.retired_[i]->Merge(*sites_[i]);
+    for (std::size_t i = 0; i < registry_.threads_.size(); ++i)
+      if (registry_.threads_[i] == this)
+      {
+        registry_.threads_[i] = registry_.threads_.back();
+        registry_.threads_.pop_back();
+        break;
+      }
+  }
+
+private:
+  friend class InstrumentRegistry;
+
+  InstrumentThread()
+    : registry_(InstrumentRegistry::Instance())
+  {
+    std::lock_guard<std::mutex> lock(registry_.mutex_);
+    registry_.threads_.push_back(this);
+  }
+
+  InstrumentCounters& Grow(std::size_t site)
+  {
+    std::lock_guard<std::mutex> lock(registry_.mutex_);
+    if (site >= sites_.size())
+      sites_.resize(site + 1);
+    sites_[site] = std::make_unique<InstrumentCounters>();
+    return *sites_[site];
+  }
+
+  InstrumentRegistry& registry_;
+  std::vector<std::unique_ptr<InstrumentCounters>> sites_;
+};
+
+inline std::vector<InstrumentStatistics> InstrumentRegistry::Snapshot()
+{
+  const double scale = NanosecondsPerTick();
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<InstrumentStatistics> snapshot(names_.size());
+  for (std::size_t site = 0; site < names_.size(); ++site)
+  {
+    InstrumentCounters merged;
+    merged.Merge(*retired_[site]);
+    for (const InstrumentThread* thread : threads_)
+      if (site < thread->sites_.size() && thread->sites_[site] != nullptr)
+        merged.Merge(*thread->sites_[site]);
+
+    InstrumentStatistics& statistics = snapshot[site];
+    statistics.name = names_[site];
+    statistics.calls = merged.calls.load(std::memory_order_relaxed);
+    statistics.samples = merged.samples.load(std::memory_order_relaxed);
+    if (statistics.samples == 0)
+      continue;
+    statistics.mean = merged.ticks.load(std::memory_order_relaxed) * scale / statistics.samples;
+    statistics.max = merged.max.load(std::memory_order_relaxed) * scale;
+    // Bucket counts and the sample count are read separately, so rank against the bucket total
+    std::uint64_t total = 0;
+    for (const std::atomic<std::uint64_t>& bucket : merged.buckets)
+      total += bucket.load(std::memory_order_relaxed);
+    double* percentiles[] = { &statistics.p50, &statistics.p90, &statistics.p99 };
+    const double ranks[] = { 0.5, 0.9, 0.99 };
+    std::uint64_t seen = 0;
+    std::size_t next = 0;
+    for (std::size_t bucket = 0; bucket < InstrumentHistogram::Size && next < 3; ++bucket)
+    {
+      seen += merged.buckets[bucket].load(std::memory_order_relaxed);
+      while (next < 3 && seen != 0 && static_cast<double>(seen) >= ranks[next] * static_cast<double>(total))
+        *percentiles[next++] = InstrumentHistogram::Value(bucket) * scale;
+    }
+  }
+  return snapshot;
+}
+
+// Wrapper with the callable's own signature, so it fits any slot the callable
+// fits. Every call is counted; with a sample period of N (a power of two)
+// only every N-th call on each thread is timed, which keeps the clock reads
+// off most calls.
+
+template <class Function, class Signature = typename FunctionType<Function>::Type>
+class Instrumented;
+
+template <class Function, class Return, typename ...Args>
+class Instrumented<Function, Return(Args...)>
+{
+  static_assert(!std::is_member_function_pointer<Function>::value, "Instrument requires a callable, bind member functions to an object first.");
+
+public:
+  Instrumented(Function function, const char* name, std::uint64_t period = 1)
+    : function_(std::move(function)), site_(InstrumentRegistry::Instance().Register(name)), mask_(period - 1)
+  {
+    assert(period != 0 && (period & mask_) == 0 && "Instrument sample period must be a power of two.");
+  }
+
+  // Noexcept like the callable, so it also fits noexcept slots
+  Return operator()(Args... args) const noexcept(FunctionType<Function>::IsNoexcept)
+  {
+    InstrumentCounters& counters = InstrumentThread::Counters(site_);
+    if ((counters.Count() & mask_) != 0)
+      return function_(std::forward<Args>(args)...);
+    // Records when the call returns or throws
+    struct Timer
+    {
+      InstrumentCounters& counters;
+      std::uint64_t start;
+      ~Timer() { counters.Record(InstrumentClock::Now() - start); }
+    } timer{ counters, InstrumentClock::Now() };
+    return function_(std::forward<Args>(args)...);
+  }
+
+private:
+  mutable Function function_;
+  std::size_t site_;
+  std::uint64_t mask_;
+};
+
+template <class Function>
+Instrumented<std::decay_t<Function>> Instrument(Function&& function, const char* name, std::uint64_t period = 1)
+{
+  return { std::forward<Function>(function), name, period };
+}
+
+inline std::vector<InstrumentStatistics> InstrumentSnapshot()
+{
+  return InstrumentRegistry::Instance().Snapshot();
+}
+
+// Background thread that appends a snapshot of every call site to a file
+// each period, and a final one when destroyed. Each line is tab-separated:
+// milliseconds since the aggregator started, name, calls, samples, then mean, p50,
+// p90, p99 and max latency in nanoseconds.
+
+class InstrumentAggregator
+{
+public:
+  InstrumentAggregator(std::string path, std::chrono::milliseconds period)
+    : path_(std::move(path)), period_(period), start_(std::chrono::steady_clock::now()), thread_([this]() { Run(); }) {}
+
+  InstrumentAggregator(const InstrumentAggregator&) = delete;
+  InstrumentAggregator& operator=(const InstrumentAggregator&) = delete;
+
+  ~InstrumentAggregator()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+    Write();
+  }
+
+  void Write()
+  {
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_).count();
+    std::ofstream file(path_, std::ios::app);
+    for (const InstrumentStatistics& statistics : InstrumentSnapshot())
+      file << elapsed << '\t' << statistics.name << '\t' << statistics.calls << '\t' << statistics.samples << '\t' << statistics.mean << '\t'
+        << statistics.p50 << '\t' << statistics.p90 << '\t' << statistics.p99 << '\t' << statistics.max << '\n';
+  }
+
+private:
+  void Run()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!wake_.wait_for(lock, period_, [this]() { return stop_; }))
+    {
+      lock.unlock();
+      Write();
+      lock.lock();
+    }
+  }
+
+  std::string path_;
+  std::chrono::milliseconds period_;
+  std::chrono::steady_clock::time_point start_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+#else
+
+template <class Function>
+std::decay_t<Function> Instrument(Function&& function, const char*, std::uint64_t = 1)
+{
+  return std::forward<Function>(function);
+}
+
+inline std::vector<InstrumentStatistics> InstrumentSnapshot() { return {}; }
+
+class InstrumentAggregator
+{
+public:
+  InstrumentAggregator(std::string, std::chrono::milliseconds) {}
+  void Write() {}
+};
+
+#endif // !INSTRUMENT_DISABLED
+
+#endif // INSTRUMENT
@@ -0,0 +1,289 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef MEMOIZE
+#define MEMOIZE
+#pragma once
+
+// Requires ISO C++17 (std::optional, std::apply, fold expressions)
+
+#include "FunctionType.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Hash of a single argument, specialize for argument types without std::hash
+
+template <class T>
+struct MemoizeHash : std::hash<T> {};
+
+// Combined hash of a decayed argument tuple
+
+template <typename ...Types>
+struct MemoizeKeyHash
+{
+  std::size_t operator()(const std::tuple<Types...>& key) const
+  {
+    std::uint64_t seed = sizeof...(Types);
+    std::apply([&seed](const Types&... values)
+    {
+      ((seed ^= static_cast<std::uint64_t>(MemoizeHash<Types>()(values)) + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2)), ...);
+    }, key);
+    // Finalizer, spreads the bits used for shard selection
+    seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ull;
+    seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<std::size_t>(seed ^ (seed >> 31));
+  }
+};
+
+struct MemoizeStatistics
+{
+  std::size_t hits = 0;
+  std::size_t misses = 0;
+  std::size_t coalesced = 0;  // misses that waited for another thread's call with the same arguments
+  std::size_t evictions = 0;
+  std::size_t size = 0;
+};
+
+// Thread-safe memoizing wrapper. Entries are split across lock-striped shards,
+// each with a fixed number of slots evicted in CLOCK order. Hits only set the
+// entry's reference bit, new entries start without it. A miss inserts a
+// pending entry and calls the function outside the lock; concurrent calls
+// with the same arguments wait for that result instead of calling again.
+
+template <class Function, class Signature = typename FunctionType<Function>::Type>
+class Memoized;
+
+template <class Function, class Return, typename ...Args>
+class Memoized<Function, Return(Args...)>
+{
+  static_assert(!std::is_void<Return>::value, "Memoize requires a function with a return value.");
+  static_assert(((!std::is_lvalue_reference<Args>::value || std::is_const<std::remove_reference_t<Args>>::value) && ...),
+    "Memoize cannot cache functions that take non-const lvalue reference arguments.");
+
+public:
+  using Key = std::tuple<std::decay_t<Args>...>;
+  using Value = std::decay_t<Return>;
+
+  // Capacity is the total number of cached results, shards defaults to four per hardware thread
+  Memoized(Function function, std::size_t capacity, std::size_t shards = 0)
+    : function_(std::move(function))
+  {
+    std::size_t count = 1;
+    const std::size_t requested = shards != 0 ? shards : 4 * std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    while (count < requested && count * 2 <= std::max<std::size_t>(capacity, 1))
+      count *= 2;
+    shards_ = std::make_unique<Shard[]>(count);
+    mask_ = count - 1;
+    // The remainder goes to the first shards, so the total is exactly capacity
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      shards_[i].capacity = capacity / count + (i < capacity % count ? 1 : 0);
+      shards_[i].slots = std::make_unique<typename Index::iterator[]>(shards_[i].capacity);
+      shards_[i].index.reserve(shards_[i].capacity);
+      shards_[i].free.reserve(shards_[i].capacity);
+    }
+  }
+
+  Value operator()(Args... args)
+  {
+    HashedKey key{ Key(args...), 0 };
+    key.hash = MemoizeKeyHash<std::decay_t<Args>...>()(key.key);
+    // Fold the high half of the hash in, the low bits also select the bucket within the shard
+    Shard& shard = shards_[(key.hash ^ (key.hash >> (sizeof(std::size_t) * 4))) & mask_];
+
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    for (;;)
+    {
+      const auto found = shard.index.find(key);
+      if (found == shard.index.end())
+        break;
+      Entry& entry = found->second;
+      if (!entry.pending)
+      {
+        entry.referenced = true;
+        Increment(shard.hits);
+        return *entry.value;
+      }
+      Increment(shard.coalesced);
+      shard.ready.wait(lock);
+    }
+
+    Increment(shard.misses);
+    const std::size_t slot = Allocate(shard);
+    if (slot == NoSlot)
+    {
+      // Every slot of the shard is pending, call without caching
+      lock.unlock();
+      return function_(std::forward<Args>(args)...);
+    }
+    const typename Index::iterator inserted = shard.index.emplace(std::move(key), Entry{ std::nullopt, slot, true, false }).first;
+    shard.slots[slot] = inserted;
+    lock.unlock();
+
+    std::optional<Value> value;
+    try
+    {
+      value.emplace(function_(std::forward<Args>(args)...));
+      lock.lock();
+      inserted->second.value.emplace(*value);
+    }
+    catch (...)
+    {
+      // The function or the copy into the cache threw; waiting calls retry,
+      // one of them calls the function again
+      if (!lock.owns_lock())
+        lock.lock();
+      shard.index.erase(inserted);
+      shard.free.push_back(slot);
+      shard.ready.notify_all();
+      throw;
+    }
+    inserted->second.pending = false;
+    shard.ready.notify_all();
+    return std::move(*value);
+  }
+
+  MemoizeStatistics Statistics() const
+  {
+    MemoizeStatistics statistics;
+    for (std::size_t i = 0; i <= mask_; ++i)
+    {
+      const Shard& shard = shards_[i];
+      statistics.hits += shard.hits.load(std::memory_order_relaxed);
+      statistics.misses += shard.misses.load(std::memory_order_relaxed);
+      statistics.coalesced += shard.coalesced.load(std::memory_order_relaxed);
+      statistics.evictions += shard.evictions.load(std::memory_order_relaxed);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      statistics.size += shard.index.size();
+    }
+    return statistics;
+  }
+
+  std::size_t ShardCount() const { return mask_ + 1; }
+
+private:
+  static constexpr std::size_t NoSlot = ~std::size_t(0);
+
+  // The argument hash is computed once, for both shard selection and lookup
+  struct HashedKey
+  {
+    Key key;
+    std::size_t hash;
+
+    bool operator==(const HashedKey& other) const { return hash == other.hash && key == other.key; }
+  };
+
+  struct StoredHash
+  {
+    std::size_t operator()(const HashedKey& key) const { return key.hash; }
+  };
+
+  struct Entry
+  {
+    std::optional<Value> value;
+    std::size_t slot;
+    bool pending;
+    bool referenced;
+  };
+
+  // Reserved to the shard's capacity, so iterators stay valid until erased
+  using Index = std::unordered_map<HashedKey, Entry, StoredHash>;
+
+  struct alignas(64) Shard
+  {
+    mutable std::mutex mutex;
+    std::condition_variable ready;
+    Index index;
+    std::unique_ptr<typename Index::iterator[]> slots;  // CLOCK order
+    std::size_t capacity = 0;
+    std::vector<std::size_t> free;
+    std::size_t used = 0;
+    std::size_t hand = 0;
+    std::atomic<std::size_t> hits{ 0 };
+    std::atomic<std::size_t> misses{ 0 };
+    std::atomic<std::size_t> coalesced{ 0 };
+    std::atomic<std::size_t> evictions{ 0 };
+  };
+
+  // Counters are only written with the shard's lock held, and read without it
+  static void Increment(std::atomic<std::size_t>& counter)
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  // Called with the shard's lock held
+  std::size_t Allocate(Shard& shard)
+  {
+    if (!shard.free.empty())
+    {
+      const std::size_t slot = shard.free.back();
+      shard.free.pop_back();
+      return slot;
+    }
+    if (shard.used < shard.capacity)
+      return shard.used++;
+    // CLOCK: clear reference bits until an unreferenced, settled entry comes around
+    for (std::size_t step = 0; step < 2 * shard.capacity; ++step)
+    {
+      const std::size_t slot = shard.hand;
+      shard.hand = shard.hand + 1 == shard.capacity ? 0 : shard.hand + 1;
+      Entry& entry = shard.slots[slot]->second;
+      if (entry.pending)
+        continue;
+      if (entry.referenced)
+      {
+        entry.referenced = false;
+        continue;
+      }
+      shard.index.erase(shard.slots[slot]);
+      Increment(shard.evictions);
+      return slot;
+    }
+    return NoSlot;
+  }
+
+  Function function_;
+  std::unique_ptr<Shard[]> shards_;
+  std::size_t mask_ = 0;
+};
+
+template <class Function>
+Memoized<std::decay_t<Function>> Memoize(Function&& function, std::size_t capacity, std::size_t shards = 0)
+{
+  return { std::forward<Function>(function), capacity, shards };
+}
+
+#endif // MEMOIZE
@@ -0,0 +1,501 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef PIPELINE
+#define PIPELINE
+#pragma once
+
+// Requires ISO C++17 (if constexpr, fold expressions)
+
+#include "FunctionType.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Capacity of the ring between two stages in elements, must be a power of two
+#if !defined(PIPELINE_RING_CAPACITY)
+#define PIPELINE_RING_CAPACITY 1024
+#endif // !PIPELINE_RING_CAPACITY
+
+// Number of elements published or consumed at once
+#if !defined(PIPELINE_BATCH_SIZE)
+#define PIPELINE_BATCH_SIZE 64
+#endif // !PIPELINE_BATCH_SIZE
+
+// Empty polls before an idle stage parks, on machines with more than one hardware thread
+#if !defined(PIPELINE_SPIN_COUNT)
+#define PIPELINE_SPIN_COUNT 4096
+#endif // !PIPELINE_SPIN_COUNT
+
+struct PipelineOptions
+{
+  std::size_t capacity = PIPELINE_RING_CAPACITY;
+  std::size_t batch = PIPELINE_BATCH_SIZE;
+};
+
+// Per-stage counters, the queue figures describe the ring feeding the stage
+
+struct PipelineStageStatistics
+{
+  std::size_t processed = 0;
+  std::size_t queued = 0;     // elements currently waiting in the input ring
+  std::size_t peak = 0;       // highest observed input ring depth
+  std::size_t stalls = 0;     // times the upstream producer found the input ring full
+  double throughput = 0.0;    // elements per second since Start
+  double utilization = 0.0;   // fraction of the time since Start spent processing, including waits on a full output ring
+};
+
+// Parks one side of a ring until the other side makes progress. The waiter
+// announces itself before checking its condition and the notifier checks for
+// a waiter after publishing, so the mutex is only taken while someone sleeps.
+
+class PipelineParking
+{
+public:
+  template <class Ready>
+  void Wait(Ready&& ready)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    condition_.wait(lock, std::forward<Ready>(ready));
+    sleeping_.store(false, std::memory_order_relaxed);
+  }
+
+  void Notify()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!sleeping_.load(std::memory_order_relaxed))
+      return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    condition_.notify_one();
+  }
+
+private:
+  std::atomic<bool> sleeping_{ false };
+  std::mutex mutex_;
+  std::condition_variable condition_;
+};
+
+// Bounded single-producer single-consumer ring. The producer publishes its
+// tail once per batch and the consumer releases its head once per batch, so
+// the shared indices are written once per batch rather than once per element.
+// A producer that finds the ring full publishes what it has and waits until
+// the consumer releases space, which is the backpressure on upstream stages.
+// Either side spins for PIPELINE_SPIN_COUNT polls before it parks.
+
+template <class T>
+class PipelineRing
+{
+public:
+  PipelineRing(std::size_t capacity, std::size_t batch)
+    : slots_(new Slot[capacity]), mask_(capacity - 1), batch_(batch)
+  {
+    assert((capacity & mask_) == 0 && "PipelineRing capacity must be a power of two.");
+    assert(batch != 0 && batch <= capacity && "PipelineRing batch must be between 1 and the capacity.");
+  }
+
+  PipelineRing(const PipelineRing&) = delete;
+  PipelineRing& operator=(const PipelineRing&) = delete;
+
+  ~PipelineRing()
+  {
+    for (std::size_t i = head_.load(std::memory_order_relaxed); i != tail_; ++i)
+      Get(i).~T();
+  }
+
+  // Producer side
+
+  template <class Value>
+  void Push(Value&& value)
+  {
+    if (tail_ - head_cache_ > mask_)
+    {
+      Flush();
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail_ - head_cache_ > mask_)
+      {
+        stalls_.store(stalls_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        for (std::size_t spin = 0; tail_ - head_cache_ > mask_; ++spin)
+        {
+          if (spin >= Spins())
+          {
+            drained_.Wait([this]() { return tail_ - head_.load(std::memory_order_acquire) <= mask_; });
+            spin = 0;
+          }
+          head_cache_ = head_.load(std::memory_order_acquire);
+        }
+      }
+    }
+    ::new (static_cast<void*>(&slots_[tail_ & mask_])) T(std::forward<Value>(value));
+    if (++tail_ - published_.load(std::memory_order_relaxed) >= batch_)
+      Flush();
+  }
+
+  void Flush()
+  {
+    // The cached head only moves when the ring looks full, refresh it so the depth is current
+    head_cache_ = head_.load(std::memory_order_acquire);
+    const std::size_t depth = tail_ - head_cache_;
+    if (depth > peak_.load(std::memory_order_relaxed))
+      peak_.store(depth, std::memory_order_relaxed);
+    published_.store(tail_, std::memory_order_release);
+    filled_.Notify();
+  }
+
+  void Close()
+  {
+    Flush();
+    closed_.store(true, std::memory_order_release);
+    filled_.Notify();
+  }
+
+  // Consumer side, calls consumer for up to a batch of elements. Returns false
+  // once the ring is closed and drained.
+
+  template <class Consumer>
+  bool Consume(Consumer&& consumer)
+  {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    for (std::size_t spin = 0; head == tail_cache_; ++spin)
+    {
+      const bool closed = closed_.load(std::memory_order_acquire);
+      tail_cache_ = published_.load(std::memory_order_acquire);
+      if (head != tail_cache_)
+        break;
+      if (closed)
+        return false;
+      if (spin >= Spins())
+      {
+        filled_.Wait([this, head]() { return published_.load(std::memory_order_acquire) != head || closed_.load(std::memory_order_acquire); });
+        spin = 0;
+      }
+    }
+    const std::size_t end = tail_cache_ - head > batch_ ? head + batch_ : tail_cache_;
+    for (std::size_t i = head; i != end; ++i)
+    {
+      T& value = Get(i);
+      consumer(value);
+      value.~T();
+    }
+    head_.store(end, std::memory_order_release);
+    drained_.Notify();
+    return true;
+  }
+
+  std::size_t Size() const { return published_.load(std::memory_order_relaxed) - head_.load(std::memory_order_relaxed); }
+  std::size_t Peak() const { return peak_.load(std::memory_order_relaxed); }
+  std::size_t Stalls() const { return stalls_.load(std::memory_order_relaxed); }
+
+private:
+  using Slot = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+  static std::size_t Spins()
+  {
+    static const std::size_t spins = std::thread::hardware_concurrency() > 1 ? PIPELINE_SPIN_COUNT : 0;
+    return spins;
+  }
+
+  T& Get(std::size_t index) { return *std::launder(reinterpret_cast<T*>(&slots_[index & mask_])); }
+
+  std::unique_ptr<Slot[]> slots_;
+  std::size_t mask_;
+  std::size_t batch_;
+  alignas(64) std::atomic<std::size_t> published_{ 0 };
+  std::atomic<bool> closed_{ false };
+  alignas(64) std::atomic<std::size_t> head_{ 0 };
+  alignas(64) std::size_t tail_ = 0;        // producer
+  std::size_t head_cache_ = 0;              // producer
+  std::atomic<std::size_t> peak_{ 0 };
+  std::atomic<std::size_t> stalls_{ 0 };
+  alignas(64) std::size_t tail_cache_ = 0;  // consumer
+  PipelineParking filled_;                  // the consumer waits for elements
+  PipelineParking drained_;                 // the producer waits for space
+};
+
+// Stage type check, each stage takes the previous stage's decayed return type
+
+template <class List>
+struct PipelineArgument
+{
+  using Type = void;
+  static constexpr bool Single = false;
+};
+
+template <class Argument>
+struct PipelineArgument<FunctionTypeList<Argument>>
+{
+  using Type = Argument;
+  static constexpr bool Single = true;
+};
+
+template <class Stage, class Input>
+struct PipelineStage
+{
+  using Argument = PipelineArgument<typename FunctionType<Stage>::ArgumentList>;
+  static_assert(!std::is_void<Input>::value, "Pipeline stage follows a stage that returns void.");
+  static_assert(Argument::Single, "Pipeline stages must take a single argument.");
+  static_assert(!Argument::Single || std::is_void<Input>::value || std::is_same<std::decay_t<typename Argument::Type>, Input>::value,
+    "Pipeline stage argument does not match the previous stage's return type.");
+
+  using ArgumentType = typename Argument::Type;
+  using Output = std::decay_t<typename FunctionType<Stage>::ReturnType>;
+  static constexpr bool value = true;
+};
+
+// Input type of every stage, and the chain's output type
+
+template <class Input, typename ...Stages>
+struct PipelineChain
+{
+  using Inputs = FunctionTypeList<>;
+  using Output = Input;
+};
+
+template <class Input, class Stage, typename ...Rest>
+struct PipelineChain<Input, Stage, Rest...>
+{
+  template <typename ...Types>
+  using Prepend = FunctionTypeList<Input, Types...>;
+
+  using Next = PipelineChain<typename PipelineStage<Stage, Input>::Output, Rest...>;
+  using Inputs = typename Next::Inputs::template Apply<Prepend>;
+  using Output = typename Next::Output;
+};
+
+template <class Input, typename ...Stages>
+class PipelineExecution;
+
+// Chain of stages built with operator|, checked as each stage is appended
+
+template <class Input, typename ...Stages>
+class Pipeline
+{
+public:
+  using InputType = Input;
+  using OutputType = typename PipelineChain<Input, Stages...>::Output;
+
+  static constexpr std::size_t StageCount = sizeof...(Stages);
+
+  explicit Pipeline(std::tuple<Stages...> stages)
+    : stages_(std::move(stages)) {}
+
+  template <class Stage>
+  Pipeline<Input, Stages..., std::decay_t<Stage>> operator|(Stage&& stage) &&
+  {
+    static_assert(PipelineStage<std::decay_t<Stage>, OutputType>::value, "");
+    return Pipeline<Input, Stages..., std::decay_t<Stage>>(std::tuple_cat(std::move(stages_), std::make_tuple(std::forward<Stage>(stage))));
+  }
+
+  template <class Stage>
+  Pipeline<Input, Stages..., std::decay_t<Stage>> operator|(Stage&& stage) const&
+  {
+    return Pipeline(*this) | std::forward<Stage>(stage);
+  }
+
+  // Starts one thread per stage, with copies of the stages (or the stages themselves, from an rvalue)
+  PipelineExecution<Input, Stages...> Start(PipelineOptions options = {}) const&
+  {
+    return PipelineExecution<Input, Stages...>(stages_, options);
+  }
+
+  PipelineExecution<Input, Stages...> Start(PipelineOptions options = {}) &&
+  {
+    return PipelineExecution<Input, Stages...>(std::move(stages_), options);
+  }
+
+private:
+  std::tuple<Stages...> stages_;
+};
+
+template <class Input>
+Pipeline<Input> MakePipeline()
+{
+  return Pipeline<Input>(std::tuple<>());
+}
+
+// Running pipeline. Push feeds the first stage from a single producer thread,
+// Finish drains every stage, joins the threads and rethrows the first
+// exception thrown by a stage. Elements reaching a failed stage are dropped.
+
+template <class Input, typename ...Stages>
+class PipelineExecution
+{
+  static_assert(sizeof...(Stages) != 0, "Pipeline requires at least one stage.");
+  static_assert(std::is_void<typename PipelineChain<Input, Stages...>::Output>::value, "Pipeline requires the last stage to return void.");
+
+  template <typename ...Types>
+  using Rings = std::tuple<std::unique_ptr<PipelineRing<Types>>...>;
+
+public:
+  PipelineExecution(std::tuple<Stages...> stages, PipelineOptions options)
+    : stages_(std::move(stages))
+  {
+    std::apply([&options](auto&... rings)
+    {
+      ((rings = std::make_unique<typename std::decay_t<decltype(rings)>::element_type>(options.capacity, options.batch)), ...);
+    }, rings_);
+    start_ = std::chrono::steady_clock::now();
+    Launch(std::index_sequence_for<Stages...>());
+  }
+
+  PipelineExecution(const PipelineExecution&) = delete;
+  PipelineExecution& operator=(const PipelineExecution&) = delete;
+
+  ~PipelineExecution()
+  {
+    if (!finished_)
+      Drain();
+  }
+
+  template <class Value>
+  void Push(Value&& value)
+  {
+    std::get<0>(rings_)->Push(std::forward<Value>(value));
+  }
+
+  // Makes the elements pushed so far visible to the first stage without waiting for a full batch
+  void Flush() { std::get<0>(rings_)->Flush(); }
+
+  void Finish()
+  {
+    Drain();
+    for (Stage& stage : counters_)
+      if (stage.failure)
+        std::rethrow_exception(stage.failure);
+  }
+
+  std::vector<PipelineStageStatistics> Statistics() const
+  {
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    std::vector<PipelineStageStatistics> statistics(sizeof...(Stages));
+    std::size_t index = 0;
+    std::apply([&](const auto&... rings)
+    {
+      ((statistics[index].queued = rings->Size(), statistics[index].peak = rings->Peak(), statistics[index].stalls = rings->Stalls(), ++index), ...);
+    }, rings_);
+    for (std::size_t i = 0; i < sizeof...(Stages); ++i)
+    {
+      statistics[i].processed = counters_[i].processed.load(std::memory_order_relaxed);
+      statistics[i].throughput = elapsed > 0.0 ? statistics[i].processed / elapsed : 0.0;
+      statistics[i].utilization = elapsed > 0.0 ? counters_[i].busy.load(std::memory_order_relaxed) / 1e9 / elapsed : 0.0;
+    }
+    return statistics;
+  }
+
+private:
+  struct alignas(64) Stage
+  {
+    std::atomic<std::size_t> processed{ 0 };
+    std::atomic<std::int64_t> busy{ 0 };  // nanoseconds
+    std::exception_ptr failure;
+  };
+
+  // Counters are only written by the stage's thread
+  template <class Counter, class Value>
+  static void Add(std::atomic<Counter>& counter, Value value)
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + static_cast<Counter>(value), std::memory_order_relaxed);
+  }
+
+  template <std::size_t ...Indices>
+  void Launch(std::index_sequence<Indices...>)
+  {
+    (threads_.emplace_back([this]() { Run<Indices>(); }), ...);
+  }
+
+  template <std::size_t Index>
+  void Run()
+  {
+    using Argument = typename PipelineStage<std::tuple_element_t<Index, std::tuple<Stages...>>,
+      typename PipelineChain<Input, Stages...>::Inputs::template At<Index>>::ArgumentType;
+    auto& input = *std::get<Index>(rings_);
+    auto& stage = std::get<Index>(stages_);
+    Stage& counters = counters_[Index];
+    bool failed = false;
+    for (;;)
+    {
+      std::chrono::steady_clock::time_point start;
+      std::size_t processed = 0;
+      const bool open = input.Consume([&](auto& value)
+      {
+        if (failed)
+          return;
+        // Waiting for input is not busy time, the clock starts at the batch's first element
+        if (processed == 0)
+          start = std::chrono::steady_clock::now();
+        try
+        {
+          if constexpr (Index + 1 == sizeof...(Stages))
+            stage(static_cast<Argument&&>(value));
+          else
+            std::get<Index + 1>(rings_)->Push(stage(static_cast<Argument&&>(value)));
+          ++processed;
+        }
+        catch (...)
+        {
+          counters.failure = std::current_exception();
+          failed = true;
+        }
+      });
+      if (!open)
+        break;
+      if (processed != 0)
+      {
+        Add(counters.processed, processed);
+        Add(counters.busy, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+      }
+    }
+    if constexpr (Index + 1 < sizeof...(Stages))
+      std::get<Index + 1>(rings_)->Close();
+  }
+
+  void Drain()
+  {
+    finished_ = true;
+    std::get<0>(rings_)->Close();
+    for (std::thread& thread : threads_)
+      thread.join();
+  }
+
+  std::tuple<Stages...> stages_;
+  typename PipelineChain<Input, Stages...>::Inputs::template Apply<Rings> rings_;
+  Stage counters_[sizeof...(Stages)];
+  std::vector<std::thread> threads_;
+  std::chrono::steady_clock::time_point start_;
+  bool finished_ = false;
+};
+
+#endif // PIPELINE
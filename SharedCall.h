@@ -0,0 +1,604 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef SHARED_CALL
+#define SHARED_CALL
+#pragma once
+
+// Requires ISO C++17 (if constexpr, fold expressions) and POSIX (mmap)
+
+#include "FunctionType.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif // __linux__
+
+// Capacity of each ring in bytes, must be a power of two
+#if !defined(SHARED_CALL_RING_CAPACITY)
+#define SHARED_CALL_RING_CAPACITY (1 << 20)
+#endif // !SHARED_CALL_RING_CAPACITY
+
+// Empty polls before a consumer sleeps on the doorbell, on machines with more than one hardware thread
+#if !defined(SHARED_CALL_SPIN_COUNT)
+#define SHARED_CALL_SPIN_COUNT 4096
+#endif // !SHARED_CALL_SPIN_COUNT
+
+// Wire format of an argument or return type. Trivially copyable types are
+// stored as they are; specialize SharedCallAdapter for other types with a
+// trivially copyable Wire type, Encode(Wire&, const T&) and Decode(const Wire&).
+
+template <class T, typename = void>
+struct SharedCallAdapter
+{
+  static_assert(AlwaysFalse<T>, "SharedCall argument and return types must be trivially copyable, or have a SharedCallAdapter specialization.");
+};
+
+template <class T>
+struct SharedCallAdapter<T, std::enable_if_t<std::is_trivially_copyable<T>::value>>
+{
+  using Wire = T;
+  static void Encode(Wire& wire, const T& value) { std::memcpy(static_cast<void*>(&wire), &value, sizeof(T)); }
+  static const T& Decode(const Wire& wire) { return wire; }
+};
+
+// Flat layout of a list of types: each wire value at a naturally aligned offset
+
+template <typename ...Types>
+struct SharedCallLayout
+{
+  static_assert(((!std::is_pointer<Types>::value && !std::is_member_pointer<Types>::value) && ...), "SharedCall cannot marshal pointers across processes.");
+
+  template <std::size_t Index>
+  using Wire = typename SharedCallAdapter<typename FunctionTypeList<Types...>::template At<Index>>::Wire;
+
+  struct Offsets
+  {
+    std::size_t offset[sizeof...(Types) + 1];
+  };
+
+  static constexpr Offsets Compute()
+  {
+    constexpr std::size_t sizes[] = { sizeof(typename SharedCallAdapter<Types>::Wire)..., 0 };
+    constexpr std::size_t alignments[] = { alignof(typename SharedCallAdapter<Types>::Wire)..., 1 };
+    Offsets offsets{};
+    std::size_t position = 0;
+    for (std::size_t i = 0; i < sizeof...(Types); ++i)
+    {
+      position = (position + alignments[i] - 1) & ~(alignments[i] - 1);
+      offsets.offset[i] = position;
+      position += sizes[i];
+    }
+    offsets.offset[sizeof...(Types)] = position;
+    return offsets;
+  }
+
+  static constexpr Offsets Table = Compute();
+  static constexpr std::size_t Size = Table.offset[sizeof...(Types)];
+  static constexpr std::size_t Alignment = std::max({ std::size_t(1), alignof(typename SharedCallAdapter<Types>::Wire)... });
+
+  template <std::size_t Index>
+  static constexpr std::size_t Offset = Table.offset[Index];
+
+  template <class Handler>
+  static constexpr bool Invocable = std::is_invocable<Handler&, decltype(SharedCallAdapter<Types>::Decode(std::declval<const typename SharedCallAdapter<Types>::Wire&>()))...>::value;
+
+  template <typename ...Values>
+  static void Encode(void* buffer, const Values&... values)
+  {
+    Encode(buffer, std::index_sequence_for<Types...>(), values...);
+  }
+
+  // Calls handler with the decoded values, read in place from the buffer
+  template <class Handler>
+  static decltype(auto) Invoke(Handler& handler, const void* buffer)
+  {
+    return Invoke(handler, buffer, std::index_sequence_for<Types...>());
+  }
+
+private:
+  template <std::size_t Index>
+  static const Wire<Index>& Get(const void* buffer)
+  {
+    return *std::launder(reinterpret_cast<const Wire<Index>*>(static_cast<const unsigned char*>(buffer) + Offset<Index>));
+  }
+
+  template <std::size_t ...Indices, typename ...Values>
+  static void Encode(void* buffer, std::index_sequence<Indices...>, const Values&... values)
+  {
+    static_cast<void>(buffer);
+    (SharedCallAdapter<Types>::Encode(*::new (static_cast<unsigned char*>(buffer) + Offset<Indices>) Wire<Indices>, values), ...);
+  }
+
+  template <class Handler, std::size_t ...Indices>
+  static decltype(auto) Invoke(Handler& handler, const void* buffer, std::index_sequence<Indices...>)
+  {
+    static_cast<void>(buffer);
+    return handler(SharedCallAdapter<Types>::Decode(Get<Indices>(buffer))...);
+  }
+};
+
+template <typename ...Args>
+struct SharedCallArguments
+{
+  static_assert(((!std::is_lvalue_reference<Args>::value || std::is_const<std::remove_reference_t<Args>>::value) && ...),
+    "SharedCall cannot marshal non-const lvalue reference arguments, results are only passed back through the return value.");
+  using Layout = SharedCallLayout<std::decay_t<Args>...>;
+};
+
+// Layout of a function type's arguments and return value, derived through FunctionType
+
+template <class Signature>
+struct SharedCallSignature
+{
+  static_assert(std::is_function<Signature>::value, "SharedCall signatures must be function types, for example decltype(Function).");
+  using Type = typename FunctionType<Signature*>::Type;
+  using ReturnType = typename FunctionType<Signature*>::ReturnType;
+  using Arguments = typename FunctionType<Signature*>::ArgumentList::template Apply<SharedCallArguments>::Layout;
+  using Return = std::conditional_t<std::is_void<ReturnType>::value, SharedCallLayout<>, SharedCallLayout<std::decay_t<ReturnType>>>;
+};
+
+// The signatures both processes agree on, calls are identified by index
+
+template <class ...Signatures>
+struct SharedCallInterface
+{
+  static constexpr std::size_t Size = sizeof...(Signatures);
+
+  template <std::size_t Index>
+  using Signature = SharedCallSignature<typename FunctionTypeList<Signatures...>::template At<Index>>;
+};
+
+// Message header, the payload follows at a 16 byte aligned offset
+
+struct SharedCallMessage
+{
+  enum : std::uint32_t
+  {
+    Reply = 1,     // the sender waits for a response
+    Failed = 2,    // the handler threw, the response has no value
+    Unknown = 4,   // with Failed, the server has no signature with the request's index
+  };
+
+  enum : std::uint32_t
+  {
+    Padding = 0xFFFFFFFF,  // skip to the start of the ring
+    Close = 0xFFFFFFFE,    // the client has closed the channel
+  };
+
+  std::uint32_t size;
+  std::uint32_t index;
+  std::uint32_t flags;
+  std::uint32_t reserved;
+
+  static constexpr std::size_t Alignment = 16;
+
+  void* Payload() { return reinterpret_cast<unsigned char*>(this) + sizeof(SharedCallMessage); }
+  const void* Payload() const { return reinterpret_cast<const unsigned char*>(this) + sizeof(SharedCallMessage); }
+
+  static constexpr std::uint32_t SizeFor(std::size_t payload)
+  {
+    return static_cast<std::uint32_t>((sizeof(SharedCallMessage) + payload + Alignment - 1) & ~(Alignment - 1));
+  }
+};
+
+static_assert(sizeof(SharedCallMessage) == SharedCallMessage::Alignment, "SharedCallMessage header must keep the payload aligned.");
+
+// Single-producer single-consumer byte ring placed in shared memory. The
+// producer reserves and commits messages locally and makes them visible with
+// Publish, which also rings the doorbell once for the whole batch.
+
+class SharedCallRing
+{
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+    "SharedCall requires address-free lock-free atomics.");
+
+public:
+  explicit SharedCallRing(std::size_t capacity) : capacity_(capacity) {}
+
+  static constexpr std::size_t Footprint(std::size_t capacity) { return sizeof(SharedCallRing) + capacity; }
+
+  // Producer side
+
+  SharedCallMessage* Reserve(std::size_t payload)
+  {
+    const std::uint32_t size = SharedCallMessage::SizeFor(payload);
+    if (size > capacity_ / 2)
+      throw std::length_error("SharedCall message does not fit into the ring.");
+    const std::size_t offset = pending_ & (capacity_ - 1);
+    const std::size_t skip = offset + size > capacity_ ? capacity_ - offset : 0;
+    while (pending_ + skip + size - tail_.load(std::memory_order_acquire) > capacity_)
+    {
+      Publish();
+      std::this_thread::yield();
+    }
+    if (skip != 0)
+    {
+      SharedCallMessage* padding = At(pending_);
+      padding->size = static_cast<std::uint32_t>(skip);
+      padding->index = SharedCallMessage::Padding;
+      pending_ += skip;
+    }
+    SharedCallMessage* message = At(pending_);
+    message->size = size;
+    return message;
+  }
+
+  void Commit(const SharedCallMessage* message) { pending_ += message->size; }
+
+  void Publish()
+  {
+    if (pending_ == head_.load(std::memory_order_relaxed))
+      return;
+    head_.store(pending_, std::memory_order_seq_cst);
+    doorbell_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_seq_cst) != 0)
+      Wake();
+  }
+
+  // Consumer side
+
+  // Returns the next published message, or nullptr after waiting when block is true
+  const SharedCallMessage* Peek(bool block)
+  {
+    static const std::size_t spins = std::thread::hardware_concurrency() > 1 ? SHARED_CALL_SPIN_COUNT : 0;
+    for (std::size_t spin = 0;; ++spin)
+    {
+      if (const SharedCallMessage* message = Front())
+        return message;
+      if (!block)
+        return nullptr;
+      if (spin < spins)
+        continue;
+      sleeping_.store(1, std::memory_order_seq_cst);
+      const std::uint32_t doorbell = doorbell_.load(std::memory_order_seq_cst);
+      if (Front() == nullptr)
+        Wait(doorbell);
+      sleeping_.store(0, std::memory_order_relaxed);
+      spin = 0;
+    }
+  }
+
+  void Release(const SharedCallMessage* message)
+  {
+    tail_.store(tail_.load(std::memory_order_relaxed) + message->size, std::memory_order_release);
+  }
+
+private:
+  SharedCallMessage* At(std::uint64_t position)
+  {
+    return reinterpret_cast<SharedCallMessage*>(reinterpret_cast<unsigned char*>(this + 1) + (position & (capacity_ - 1)));
+  }
+
+  const SharedCallMessage* Front()
+  {
+    std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      if (tail == head_.load(std::memory_order_acquire))
+        return nullptr;
+      const SharedCallMessage* message = At(tail);
+      if (message->index != SharedCallMessage::Padding)
+        return message;
+      tail += message->size;
+      tail_.store(tail, std::memory_order_release);
+    }
+  }
+
+  void Wait(std::uint32_t doorbell)
+  {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&doorbell_), FUTEX_WAIT, doorbell, nullptr, nullptr, 0);
+#else
+    if (doorbell_.load() == doorbell)
+      std::this_thread::yield();
+#endif // __linux__
+  }
+
+  void Wake()
+  {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&doorbell_), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#endif // __linux__
+  }
+
+  // Producer owned
+  alignas(64) std::atomic<std::uint64_t> head_{ 0 };
+  std::atomic<std::uint32_t> doorbell_{ 0 };
+  std::uint64_t pending_ = 0;
+  // Consumer owned
+  alignas(64) std::atomic<std::uint64_t> tail_{ 0 };
+  std::atomic<std::uint32_t> sleeping_{ 0 };
+  alignas(64) std::size_t capacity_;
+};
+
+// A memory-mapped file holding a request ring and a response ring
+
+class SharedCallChannel
+{
+public:
+  // Creates, or truncates, the file and initializes both rings
+  static SharedCallChannel Create(const std::string& path, std::size_t capacity = SHARED_CALL_RING_CAPACITY)
+  {
+    if (capacity < 2 * SharedCallMessage::Alignment || (capacity & (capacity - 1)) != 0)
+      throw std::invalid_argument("SharedCallChannel capacity must be a power of two.");
+    const std::size_t size = 2 * SharedCallRing::Footprint(capacity);
+    SharedCallChannel channel(path, O_RDWR | O_CREAT | O_TRUNC, size);
+    ::new (channel.memory_) SharedCallRing(capacity);
+    ::new (static_cast<unsigned char*>(channel.memory_) + SharedCallRing::Footprint(capacity)) SharedCallRing(capacity);
+    return channel;
+  }
+
+  // Maps a file created by Create in another process
+  static SharedCallChannel Open(const std::string& path)
+  {
+    return SharedCallChannel(path, O_RDWR, 0);
+  }
+
+  SharedCallChannel(SharedCallChannel&& other) noexcept
+    : memory_(std::exchange(other.memory_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+  SharedCallChannel& operator=(SharedCallChannel&&) = delete;
+
+  ~SharedCallChannel()
+  {
+    if (memory_ != nullptr)
+      munmap(memory_, size_);
+  }
+
+  SharedCallRing& Requests() { return *std::launder(static_cast<SharedCallRing*>(memory_)); }
+  SharedCallRing& Responses() { return *std::launder(reinterpret_cast<SharedCallRing*>(static_cast<unsigned char*>(memory_) + size_ / 2)); }
+
+private:
+  SharedCallChannel(const std::string& path, int flags, std::size_t size)
+  {
+    const int file = open(path.c_str(), flags, 0600);
+    if (file < 0)
+      throw std::system_error(errno, std::generic_category(), "SharedCallChannel cannot open " + path);
+    struct stat status;
+    if ((size != 0 ? ftruncate(file, static_cast<off_t>(size)) : fstat(file, &status)) != 0)
+    {
+      const int error = errno;
+      close(file);
+      throw std::system_error(error, std::generic_category(), "SharedCallChannel cannot size " + path);
+    }
+    size_ = size != 0 ? size : static_cast<std::size_t>(status.st_size);
+    memory_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    const int error = errno;
+    close(file);
+    if (memory_ == MAP_FAILED)
+    {
+      memory_ = nullptr;
+      throw std::system_error(error, std::generic_category(), "SharedCallChannel cannot map " + path);
+    }
+  }
+
+  void* memory_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// Caller side. Call blocks for the result; Post only queues the call, and
+// Flush publishes every queued call with a single doorbell.
+
+template <class Interface>
+class SharedCallClient
+{
+public:
+  explicit SharedCallClient(SharedCallChannel& channel)
+    : requests_(channel.Requests()), responses_(channel.Responses()) {}
+
+  template <std::size_t Index>
+  using ReturnType = std::decay_t<typename Interface::template Signature<Index>::ReturnType>;
+
+  template <std::size_t Index, typename ...Values>
+  ReturnType<Index> Call(Values&&... values)
+  {
+    using Signature = typename Interface::template Signature<Index>;
+    Write<Index>(SharedCallMessage::Reply, values...);
+    requests_.Publish();
+    const SharedCallMessage* response = responses_.Peek(true);
+    struct Release
+    {
+      SharedCallRing& ring;
+      const SharedCallMessage* message;
+      ~Release() { ring.Release(message); }
+    } release{ responses_, response };
+    if (response->flags & SharedCallMessage::Unknown)
+      throw std::runtime_error("SharedCall server has no handler for this call.");
+    if (response->flags & SharedCallMessage::Failed)
+      throw std::runtime_error("SharedCall handler threw an exception.");
+    if constexpr (!std::is_void<ReturnType<Index>>::value)
+    {
+      auto identity = [](const auto& value) -> ReturnType<Index> { return value; };
+      return Signature::Return::Invoke(identity, response->Payload());
+    }
+  }
+
+  template <std::size_t Index, typename ...Values>
+  void Post(Values&&... values)
+  {
+    Write<Index>(0, values...);
+  }
+
+  void Flush() { requests_.Publish(); }
+
+  // Stops the server's Run loop
+  void Close()
+  {
+    SharedCallMessage* message = requests_.Reserve(0);
+    message->index = SharedCallMessage::Close;
+    message->flags = 0;
+    requests_.Commit(message);
+    requests_.Publish();
+  }
+
+private:
+  template <std::size_t Index, typename ...Values>
+  void Write(std::uint32_t flags, const Values&... values)
+  {
+    static_assert(Index < Interface::Size, "SharedCall index is out of the interface's range.");
+    using Arguments = typename Interface::template Signature<Index>::Arguments;
+    static_assert(Arguments::Alignment <= SharedCallMessage::Alignment, "SharedCall argument alignment exceeds the message alignment.");
+    static_assert(sizeof...(Values) == FunctionType<typename Interface::template Signature<Index>::Type*>::Arity, "SharedCall called with the wrong number of arguments.");
+    SharedCallMessage* message = requests_.Reserve(Arguments::Size);
+    message->index = static_cast<std::uint32_t>(Index);
+    message->flags = flags;
+    Arguments::Encode(message->Payload(), values...);
+    requests_.Commit(message);
+  }
+
+  SharedCallRing& requests_;
+  SharedCallRing& responses_;
+};
+
+// Callee side, each handler is called directly with arguments read in place
+
+template <class Interface, class ...Handlers>
+class SharedCallServer
+{
+  static_assert(sizeof...(Handlers) == Interface::Size, "SharedCallServer requires one handler per interface signature.");
+
+public:
+  SharedCallServer(SharedCallChannel& channel, Handlers... handlers)
+    : requests_(channel.Requests()), responses_(channel.Responses()), handlers_(std::move(handlers)...) {}
+
+  // Handles every published call, returns false once the client has closed the channel.
+  // An exception from a post handler leaves Poll after the replies committed so far are published.
+  bool Poll(bool block = false)
+  {
+    struct Publish
+    {
+      SharedCallRing& ring;
+      ~Publish() { ring.Publish(); }
+    } publish{ responses_ };
+    bool open = true;
+    while (open)
+    {
+      const SharedCallMessage* message = requests_.Peek(block);
+      if (message == nullptr)
+        break;
+      struct Release
+      {
+        SharedCallRing& ring;
+        const SharedCallMessage* message;
+        ~Release() { ring.Release(message); }
+      } release{ requests_, message };
+      if (message->index == SharedCallMessage::Close)
+        open = false;
+      else if (message->index >= Interface::Size)
+        Reject(message);
+      else
+        Dispatch(message, std::make_index_sequence<Interface::Size>());
+      block = false;
+    }
+    return open;
+  }
+
+  // Serves calls until the client closes the channel
+  void Run()
+  {
+    while (Poll(true))
+      ;
+  }
+
+private:
+  // A client built with a longer interface; a waiting caller gets a failed reply, posts are dropped
+  void Reject(const SharedCallMessage* request)
+  {
+    if ((request->flags & SharedCallMessage::Reply) == 0)
+      return;
+    SharedCallMessage* response = responses_.Reserve(0);
+    response->index = request->index;
+    response->flags = SharedCallMessage::Failed | SharedCallMessage::Unknown;
+    responses_.Commit(response);
+  }
+
+  template <std::size_t ...Indices>
+  void Dispatch(const SharedCallMessage* message, std::index_sequence<Indices...>)
+  {
+    ((message->index == Indices && (Handle<Indices>(message), true)) || ...);
+  }
+
+  template <std::size_t Index>
+  void Handle(const SharedCallMessage* request)
+  {
+    using Signature = typename Interface::template Signature<Index>;
+    using Return = typename Signature::ReturnType;
+    auto& handler = std::get<Index>(handlers_);
+    static_assert(Signature::Arguments::template Invocable<std::tuple_element_t<Index, std::tuple<Handlers...>>>, "SharedCallServer handler cannot be called with the signature's arguments.");
+    const bool reply = (request->flags & SharedCallMessage::Reply) != 0;
+    SharedCallMessage* response = reply ? responses_.Reserve(Signature::Return::Size) : nullptr;
+    try
+    {
+      if constexpr (std::is_void<Return>::value)
+        Signature::Arguments::Invoke(handler, request->Payload());
+      else if (reply)
+        Signature::Return::Encode(response->Payload(), static_cast<Return>(Signature::Arguments::Invoke(handler, request->Payload())));
+      else
+        Signature::Arguments::Invoke(handler, request->Payload());
+      if (reply)
+        response->flags = 0;
+    }
+    catch (...)
+    {
+      if (!reply)
+        throw;
+      response->flags = SharedCallMessage::Failed;
+    }
+    if (reply)
+    {
+      response->index = static_cast<std::uint32_t>(Index);
+      responses_.Commit(response);
+    }
+  }
+
+  SharedCallRing& requests_;
+  SharedCallRing& responses_;
+  std::tuple<Handlers...> handlers_;
+};
+
+template <class Interface, class ...Handlers>
+SharedCallServer<Interface, std::decay_t<Handlers>...> MakeSharedCallServer(SharedCallChannel& channel, Handlers&&... handlers)
+{
+  return { channel, std::forward<Handlers>(handlers)... };
+}
+
+#endif // SHARED_CALL
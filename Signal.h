@@ -0,0 +1,371 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef SIGNAL
+#define SIGNAL
+#pragma once
+
+// Requires ISO C++17 (fold expressions, if constexpr)
+
+#include "FunctionType.h"
+#include "InlineFunction.h"
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Default capacity of the cross-thread event queue, must be a power of two
+#if !defined(SIGNAL_QUEUE_CAPACITY)
+#define SIGNAL_QUEUE_CAPACITY 1024
+#endif // !SIGNAL_QUEUE_CAPACITY
+
+using SignalConnection = std::uint64_t;
+
+// Listener signature check, listeners may take the arguments by value or by reference
+
+template <typename ...Params>
+using SignalDecayedList = FunctionTypeList<std::decay_t<Params>...>;
+
+template <class Listener, typename ...Args>
+struct SignalAccepts
+{
+  static constexpr bool value = std::is_same<typename FunctionType<std::decay_t<Listener>>::ArgumentList::template Apply<SignalDecayedList>,
+    FunctionTypeList<std::decay_t<Args>...>>::value;
+};
+
+// Bounded multi-producer queue (Vyukov), each cell carries a sequence number
+
+template <class Payload>
+class SignalQueue
+{
+public:
+  explicit SignalQueue(std::size_t capacity)
+    : cells_(new Cell[capacity]), mask_(capacity - 1)
+  {
+    assert((capacity & mask_) == 0 && "SignalQueue capacity must be a power of two.");
+    for (std::size_t i = 0; i < capacity; ++i)
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  template <typename ...Values>
+  bool Push(Values&&... values)
+  {
+    std::size_t position = tail_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      Cell& cell = cells_[position & mask_];
+      const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const std::intptr_t difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+      if (difference == 0)
+      {
+        if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        {
+          ::new (static_cast<void*>(&cell.storage)) Payload(std::forward<Values>(values)...);
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (difference < 0)
+        return false;
+      else
+        position = tail_.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Single consumer, the payload is released even when consumer throws
+  template <class Consumer>
+  bool Pop(Consumer&& consumer)
+  {
+    Cell& cell = cells_[head_ & mask_];
+    if (cell.sequence.load(std::memory_order_acquire) != head_ + 1)
+      return false;
+    struct Release
+    {
+      SignalQueue& queue;
+      Cell& cell;
+      ~Release()
+      {
+        std::launder(reinterpret_cast<Payload*>(&cell.storage))->~Payload();
+        cell.sequence.store(queue.head_ + queue.mask_ + 1, std::memory_order_release);
+        ++queue.head_;
+      }
+    } release{ *this, cell };
+    consumer(*std::launder(reinterpret_cast<Payload*>(&cell.storage)));
+    return true;
+  }
+
+  ~SignalQueue()
+  {
+    while (Pop([](Payload&) {}))
+      ;
+  }
+
+private:
+  struct Cell
+  {
+    std::atomic<std::size_t> sequence;
+    std::aligned_storage_t<sizeof(Payload), alignof(Payload)> storage;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  std::size_t mask_;
+  alignas(64) std::atomic<std::size_t> tail_{ 0 };
+  alignas(64) std::size_t head_ = 0;
+};
+
+// Signal with lock-free emission. Emitters register in one of two reader counts
+// and read an immutable slot list; connect and disconnect publish a modified
+// copy and retire the old one. A retired list is freed once both reader counts
+// have been observed at zero after it was unpublished, so no emitter can still
+// hold it. Writers flip the count new emitters use, so the old one drains, and
+// never wait for emitters, which keeps connecting from inside a slot safe.
+
+template <class Signature, std::size_t SlotCapacity = INLINE_FUNCTION_CAPACITY>
+class Signal
+{
+  static_assert(AlwaysFalse<Signature>, "Signal requires a void(Args...) signature.");
+};
+
+template <typename ...Args, std::size_t SlotCapacity>
+class Signal<void(Args...), SlotCapacity>
+{
+  // Every slot receives the same arguments, each one as an lvalue
+  static_assert((!std::is_rvalue_reference<Args>::value && ...), "Signal passes each argument to every slot as an lvalue, rvalue reference parameters are not supported.");
+  static_assert(((std::is_reference<Args>::value || std::is_copy_constructible<Args>::value) && ...),
+    "Signal copies by-value arguments into every slot, move-only parameters are not supported.");
+
+public:
+  using Type = void(Args...);
+  using Slot = InlineFunction<void(Args...), SlotCapacity>;
+  using Payload = std::tuple<std::decay_t<Args>...>;
+
+  explicit Signal(std::size_t queueCapacity = SIGNAL_QUEUE_CAPACITY)
+    : queue_(queueCapacity) {}
+
+  Signal(const Signal&) = delete;
+  Signal& operator=(const Signal&) = delete;
+
+  ~Signal()
+  {
+    delete current_.load();
+    for (Retired& retired : retired_)
+      delete retired.list;
+  }
+
+  template <class Listener>
+  SignalConnection Connect(Listener&& listener)
+  {
+    static_assert(SignalAccepts<Listener, Args...>::value, "Signal listener arguments do not match the signal's arguments.");
+    std::lock_guard<std::mutex> guard(writer_);
+    const SignalConnection connection = ++connections_;
+    SlotList* list = new SlotList(*current_.load(std::memory_order_relaxed));
+    list->push_back({ connection, Slot(std::forward<Listener>(listener)) });
+    Publish(list);
+    return connection;
+  }
+
+  bool Disconnect(SignalConnection connection)
+  {
+    std::lock_guard<std::mutex> guard(writer_);
+    const SlotList& current = *current_.load(std::memory_order_relaxed);
+    SlotList* list = new SlotList();
+    list->reserve(current.size());
+    for (const Entry& entry : current)
+      if (entry.connection != connection)
+        list->push_back(entry);
+    if (list->size() == current.size())
+    {
+      delete list;
+      return false;
+    }
+    Publish(list);
+    return true;
+  }
+
+  // Calls every connected slot on the calling thread, never blocks
+  void Emit(Args... args) const
+  {
+    struct Reader
+    {
+      ReaderCount& readers;
+      ~Reader() { readers.count.fetch_sub(1); }
+    } reader{ readers_[epoch_.load() & 1] };
+    reader.readers.count.fetch_add(1);
+    for (const Entry& entry : *current_.load())
+      entry.slot(args...);
+  }
+
+  void operator()(Args... args) const { Emit(args...); }
+
+  // Queues the arguments by value for Dispatch, returns false when the queue is full
+  template <typename ...Values>
+  bool Post(Values&&... values)
+  {
+    static_assert(sizeof...(Values) == sizeof...(Args), "Signal posted with the wrong number of arguments.");
+    return queue_.Push(std::forward<Values>(values)...);
+  }
+
+  // Emits every queued event, must be called from a single consumer thread. An
+  // exception from a slot leaves Dispatch, the event it came from is not emitted again.
+  std::size_t Dispatch()
+  {
+    std::size_t dispatched = 0;
+    while (queue_.Pop([this](Payload& payload) { std::apply([this](auto&... values) { Emit(values...); }, payload); }))
+      ++dispatched;
+    return dispatched;
+  }
+
+  std::size_t SlotCount() const { return current_.load()->size(); }
+
+private:
+  struct Entry
+  {
+    SignalConnection connection;
+    Slot slot;
+  };
+
+  using SlotList = std::vector<Entry>;
+
+  struct Retired
+  {
+    SlotList* list;
+    bool drained[2];
+  };
+
+  struct alignas(64) ReaderCount
+  {
+    std::atomic<std::size_t> count{ 0 };
+  };
+
+  // Called with the writer lock held
+  void Publish(SlotList* list)
+  {
+    retired_.push_back({ current_.exchange(list), { false, false } });
+    epoch_.fetch_add(1);
+    std::size_t kept = 0;
+    for (Retired& retired : retired_)
+    {
+      for (std::size_t parity = 0; parity < 2; ++parity)
+        retired.drained[parity] = retired.drained[parity] || readers_[parity].count.load() == 0;
+      if (retired.drained[0] && retired.drained[1])
+        delete retired.list;
+      else
+        retired_[kept++] = retired;
+    }
+    retired_.resize(kept);
+  }
+
+  std::atomic<SlotList*> current_{ new SlotList() };
+  mutable std::atomic<std::size_t> epoch_{ 0 };
+  mutable ReaderCount readers_[2];
+  std::mutex writer_;
+  std::vector<Retired> retired_;
+  SignalConnection connections_ = 0;
+  SignalQueue<Payload> queue_;
+};
+
+// A set of signals, listeners are routed to the signal that matches their arguments
+
+template <typename ...Signatures>
+class EventBus
+{
+public:
+  template <class Listener>
+  SignalConnection Connect(Listener&& listener)
+  {
+    return Match<Listener>().Connect(std::forward<Listener>(listener));
+  }
+
+  template <class Signature>
+  bool Disconnect(SignalConnection connection)
+  {
+    return Get<Signature>().Disconnect(connection);
+  }
+
+  template <class Signature>
+  Signal<Signature>& Get() { return std::get<Signal<Signature>>(signals_); }
+
+  template <typename ...Values>
+  void Emit(Values&&... values)
+  {
+    Find<Values...>().Emit(std::forward<Values>(values)...);
+  }
+
+  template <typename ...Values>
+  bool Post(Values&&... values)
+  {
+    return Find<Values...>().Post(std::forward<Values>(values)...);
+  }
+
+  std::size_t Dispatch()
+  {
+    return std::apply([](auto&... signals) { return (signals.Dispatch() + ... + 0); }, signals_);
+  }
+
+private:
+  template <class Signal>
+  struct Arguments;
+
+  template <typename ...Args, std::size_t SlotCapacity>
+  struct Arguments<Signal<void(Args...), SlotCapacity>>
+  {
+    using Type = FunctionTypeList<std::decay_t<Args>...>;
+  };
+
+  template <class List, std::size_t Index = 0>
+  static constexpr std::size_t IndexOf()
+  {
+    static_assert(Index < sizeof...(Signatures), "EventBus has no signal with these arguments.");
+    if constexpr (std::is_same<typename Arguments<std::tuple_element_t<Index, std::tuple<Signal<Signatures>...>>>::Type, List>::value)
+    {
+      static_assert(((std::is_same<typename Arguments<Signal<Signatures>>::Type, List>::value ? 1 : 0) + ...) == 1,
+        "EventBus has more than one signal with these arguments.");
+      return Index;
+    }
+    else
+      return IndexOf<List, Index + 1>();
+  }
+
+  template <class Listener>
+  auto& Match()
+  {
+    using List = typename FunctionType<std::decay_t<Listener>>::ArgumentList::template Apply<SignalDecayedList>;
+    return std::get<IndexOf<List>()>(signals_);
+  }
+
+  template <typename ...Values>
+  auto& Find()
+  {
+    return std::get<IndexOf<FunctionTypeList<std::decay_t<Values>...>>()>(signals_);
+  }
+
+  std::tuple<Signal<Signatures>...> signals_;
+};
+
+#endif // SIGNAL
@@ -0,0 +1,616 @@
+/* ************************************************************************* */
+/* The MIT License(MIT)                                                      */
+/* Copyright(c) 2023 Konstantin Udovickij                                    */
+/*                                                                           */
+/* Permission is hereby granted, free of charge, to any person obtaining a   */
+/* copy of this software and associated documentation files (the "Software"),*/
+/* to deal in the Software without restriction, including without limitation */
+/* the rights to use, copy, modify, merge, publish, distribute, sublicense,  */
+/* and /or sell copies of the Software, and to permit persons to whom the    */
+/* Software is furnished to do so, subject to the following conditions:      */
+/*                                                                           */
+/* The above copyright notice and this permission notice shall be included   */
+/* in all copies or substantial portions of the Software.                    */
+/*                                                                           */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS   */
+/* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF                */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN */
+/* NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,  */
+/* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR     */
+/* OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE */
+/* USE OR OTHER DEALINGS IN THE SOFTWARE.                                    */
+/* ************************************************************************* */
+
+#ifndef TASK_EXECUTOR
+#define TASK_EXECUTOR
+#pragma once
+
+// Requires ISO C++17 (over-aligned allocation, if constexpr)
+
+#include "FunctionType.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Task slot size in bytes, one cache line by default. Tasks whose callable and
+// arguments do not fit are allocated from the executor's block pool instead.
+#if !defined(TASK_EXECUTOR_SLOT_SIZE)
+#define TASK_EXECUTOR_SLOT_SIZE 64
+#endif // !TASK_EXECUTOR_SLOT_SIZE
+
+// Per-worker queue capacity in slots, must be a power of two
+#if !defined(TASK_EXECUTOR_QUEUE_CAPACITY)
+#define TASK_EXECUTOR_QUEUE_CAPACITY 1024
+#endif // !TASK_EXECUTOR_QUEUE_CAPACITY
+
+// Pool block size for oversized tasks, larger tasks use operator new
+#if !defined(TASK_EXECUTOR_POOL_BLOCK_SIZE)
+#define TASK_EXECUTOR_POOL_BLOCK_SIZE 256
+#endif // !TASK_EXECUTOR_POOL_BLOCK_SIZE
+
+#define TASK_EXECUTOR_CACHE_LINE 64
+
+static_assert((TASK_EXECUTOR_QUEUE_CAPACITY & (TASK_EXECUTOR_QUEUE_CAPACITY - 1)) == 0, "TASK_EXECUTOR_QUEUE_CAPACITY must be a power of two.");
+static_assert(TASK_EXECUTOR_SLOT_SIZE % TASK_EXECUTOR_CACHE_LINE == 0, "TASK_EXECUTOR_SLOT_SIZE must be a multiple of the cache line size.");
+
+// Short critical sections only, yields instead of parking
+
+class TaskSpinLock
+{
+public:
+  void lock() noexcept
+  {
+    while (flag_.test_and_set(std::memory_order_acquire))
+      std::this_thread::yield();
+  }
+
+  void unlock() noexcept { flag_.clear(std::memory_order_release); }
+
+private:
+  std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+// Fixed-size block pool for tasks that do not fit into a slot
+
+class TaskPool
+{
+public:
+  static constexpr std::size_t BlockSize = TASK_EXECUTOR_POOL_BLOCK_SIZE;
+  static constexpr std::size_t BlocksPerChunk = 64;
+
+  TaskPool() = default;
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  ~TaskPool()
+  {
+    for (void* chunk : chunks_)
+      ::operator delete(chunk, std::align_val_t(TASK_EXECUTOR_CACHE_LINE));
+  }
+
+  void* Allocate(std::size_t size)
+  {
+    if (size > BlockSize)
+      return ::operator new(size, std::align_val_t(TASK_EXECUTOR_CACHE_LINE));
+    std::lock_guard<TaskSpinLock> guard(lock_);
+    if (!free_)
+    {
+      auto chunk = static_cast<unsigned char*>(::operator new(BlockSize * BlocksPerChunk, std::align_val_t(TASK_EXECUTOR_CACHE_LINE)));
+      chunks_.push_back(chunk);
+      for (std::size_t i = 0; i < BlocksPerChunk; ++i)
+        free_ = ::new (chunk + i * BlockSize) Block{ free_ };
+    }
+    Block* block = free_;
+    free_ = block->next;
+    return block;
+  }
+
+  void Deallocate(void* pointer, std::size_t size) noexcept
+  {
+    if (size > BlockSize)
+    {
+      ::operator delete(pointer, std::align_val_t(TASK_EXECUTOR_CACHE_LINE));
+      return;
+    }
+    std::lock_guard<TaskSpinLock> guard(lock_);
+    free_ = ::new (pointer) Block{ free_ };
+  }
+
+private:
+  struct Block
+  {
+    Block* next;
+  };
+
+  TaskSpinLock lock_;
+  Block* free_ = nullptr;
+  std::vector<void*> chunks_;
+};
+
+// Typed result channel, owned by the caller and filled in by the executor
+
+enum class TaskState
+{
+  Pending,
+  Value,
+  Exception
+};
+
+class TaskResultBase
+{
+public:
+  TaskResultBase() = default;
+  TaskResultBase(const TaskResultBase&) = delete;
+  TaskResultBase& operator=(const TaskResultBase&) = delete;
+
+  bool Ready() const noexcept { return state_.load(std::memory_order_acquire) != TaskState::Pending; }
+
+  void Wait() const noexcept
+  {
+    while (!Ready())
+      std::this_thread::yield();
+  }
+
+  void SetException(std::exception_ptr exception) noexcept
+  {
+    exception_ = std::move(exception);
+    state_.store(TaskState::Exception, std::memory_order_release);
+  }
+
+protected:
+  void Rethrow()
+  {
+    Wait();
+    if (state_.load(std::memory_order_relaxed) == TaskState::Exception)
+      std::rethrow_exception(exception_);
+  }
+
+  std::atomic<TaskState> state_{ TaskState::Pending };
+  std::exception_ptr exception_;
+};
+
+template <class Return>
+class TaskResult : public TaskResultBase
+{
+public:
+  using ReturnType = Return;
+
+  template <class Value>
+  void SetValue(Value&& value)
+  {
+    value_.emplace(std::forward<Value>(value));
+    state_.store(TaskState::Value, std::memory_order_release);
+  }
+
+  // Waits for completion, rethrows the task's exception if it threw
+  Return Get()
+  {
+    Rethrow();
+    return std::move(*value_);
+  }
+
+private:
+  std::optional<std::conditional_t<std::is_reference<Return>::value, std::reference_wrapper<std::remove_reference_t<Return>>, Return>> value_;
+};
+
+template <>
+class TaskResult<void> : public TaskResultBase
+{
+public:
+  using ReturnType = void;
+
+  void SetValue() noexcept { state_.store(TaskState::Value, std::memory_order_release); }
+
+  void Get() { Rethrow(); }
+};
+
+// Argument storage and compile-time argument checks
+
+template <typename ...Params>
+using TaskArguments = std::tuple<std::decay_t<Params>...>;
+
+struct TaskArgumentsMismatch
+{
+  static constexpr bool value = false;
+  static constexpr bool references = true;
+};
+
+template <class List, typename ...Args>
+struct TaskArgumentsMatch;
+
+template <typename ...Params, typename ...Args>
+struct TaskArgumentsMatch<FunctionTypeList<Params...>, Args...>
+{
+  static constexpr bool value = (std::is_constructible<std::decay_t<Params>, Args&&>::value && ...);
+  static constexpr bool references = ((!std::is_lvalue_reference<Params>::value || std::is_const<std::remove_reference_t<Params>>::value) && ...);
+};
+
+// Whether calling the function on the stored arguments cannot throw. A noexcept
+// function is not enough: moving an argument into a by-value parameter may throw.
+
+template <class Function, class Arguments>
+struct TaskNothrowCall;
+
+template <class Function, typename ...Values>
+struct TaskNothrowCall<Function, std::tuple<Values...>>
+  : std::integral_constant<bool, noexcept(std::declval<Function&>()(std::declval<Values&&>()...))> {};
+
+// A task body, stored either inline in a slot or in a pool block
+
+template <class Function, class Arguments, class Result>
+struct TaskBody
+{
+  Function function;
+  Arguments arguments;
+  Result* result;
+
+  template <class Target>
+  static constexpr bool NothrowResult()
+  {
+    using Return = typename Target::ReturnType;
+    return TaskNothrowCall<Function, Arguments>::value && (std::is_void<Return>::value || std::is_reference<Return>::value || std::is_nothrow_move_constructible<Return>::value);
+  }
+
+  void Run()
+  {
+    Run(std::make_index_sequence<std::tuple_size<Arguments>::value>());
+  }
+
+  template <std::size_t ...Indices>
+  void Run(std::index_sequence<Indices...>)
+  {
+    if constexpr (std::is_same<Result, void>::value)
+      function(std::move(std::get<Indices>(arguments))...);
+    else if constexpr (NothrowResult<Result>())
+    {
+      // Nothing can throw, so no exception is captured
+      if constexpr (std::is_void<typename Result::ReturnType>::value)
+      {
+        function(std::move(std::get<Indices>(arguments))...);
+        result->SetValue();
+      }
+      else
+        result->SetValue(function(std::move(std::get<Indices>(arguments))...));
+    }
+    else
+    {
+      try
+      {
+        if constexpr (std::is_void<typename Result::ReturnType>::value)
+        {
+          function(std::move(std::get<Indices>(arguments))...);
+          result->SetValue();
+        }
+        else
+          result->SetValue(function(std::move(std::get<Indices>(arguments))...));
+      }
+      catch (...)
+      {
+        result->SetException(std::current_exception());
+      }
+    }
+  }
+};
+
+struct alignas(TASK_EXECUTOR_CACHE_LINE) TaskSlot
+{
+  static constexpr std::size_t Capacity = TASK_EXECUTOR_SLOT_SIZE - alignof(std::max_align_t);
+
+  // Runs and destroys the task when target is null, relocates it into target otherwise
+  using Operation = void(*)(TaskSlot& self, TaskSlot* target);
+
+  Operation operation;
+  alignas(std::max_align_t) unsigned char storage[Capacity];
+
+  void Run() { operation(*this, nullptr); }
+  void RelocateTo(TaskSlot& target) noexcept { operation(*this, &target); }
+
+  template <class Body>
+  void Emplace(Body&& body, TaskPool& pool)
+  {
+    using Stored = std::decay_t<Body>;
+    if constexpr (sizeof(Stored) <= Capacity && alignof(Stored) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<Stored>::value)
+    {
+      ::new (static_cast<void*>(storage)) Stored(std::forward<Body>(body));
+      operation = &Inline<Stored>;
+    }
+    else
+    {
+      void* block = pool.Allocate(sizeof(Stored));
+      try
+      {
+        ::new (block) Stored(std::forward<Body>(body));
+      }
+      catch (...)
+      {
+        pool.Deallocate(block, sizeof(Stored));
+        throw;
+      }
+      ::new (static_cast<void*>(storage)) Pooled{ static_cast<Stored*>(block), &pool };
+      operation = &Allocated<Stored>;
+    }
+  }
+
+private:
+  struct Pooled
+  {
+    void* body;
+    TaskPool* pool;
+  };
+
+  template <class Stored>
+  static void Inline(TaskSlot& self, TaskSlot* target)
+  {
+    Stored& body = *std::launder(reinterpret_cast<Stored*>(self.storage));
+    if (target)
+    {
+      ::new (static_cast<void*>(target->storage)) Stored(std::move(body));
+      target->operation = self.operation;
+    }
+    else
+      body.Run();
+    body.~Stored();
+  }
+
+  template <class Stored>
+  static void Allocated(TaskSlot& self, TaskSlot* target)
+  {
+    Pooled& pooled = *std::launder(reinterpret_cast<Pooled*>(self.storage));
+    if (target)
+    {
+      ::new (static_cast<void*>(target->storage)) Pooled(pooled);
+      target->operation = self.operation;
+      return;
+    }
+    Stored* body = static_cast<Stored*>(pooled.body);
+    struct Release
+    {
+      Stored* body;
+      TaskPool* pool;
+      ~Release()
+      {
+        body->~Stored();
+        pool->Deallocate(body, sizeof(Stored));
+      }
+    } release{ body, pooled.pool };
+    body->Run();
+  }
+};
+
+static_assert(sizeof(TaskSlot) == TASK_EXECUTOR_SLOT_SIZE, "TaskSlot must occupy exactly TASK_EXECUTOR_SLOT_SIZE bytes.");
+
+// Per-worker deque. The owner pushes and pops at the back, thieves take from
+// the front. Slots hold tasks by value, so every end is guarded by a short,
+// normally uncontended spin lock instead of a pointer-based lock-free deque.
+
+class alignas(TASK_EXECUTOR_CACHE_LINE) TaskQueue
+{
+public:
+  TaskQueue() : slots_(new TaskSlot[TASK_EXECUTOR_QUEUE_CAPACITY]) {}
+
+  template <class Body>
+  bool Push(Body&& body, TaskPool& pool)
+  {
+    std::lock_guard<TaskSpinLock> guard(lock_);
+    if (back_ - front_ == TASK_EXECUTOR_QUEUE_CAPACITY)
+      return false;
+    slots_[back_ & Mask].Emplace(std::forward<Body>(body), pool);
+    ++back_;
+    return true;
+  }
+
+  bool Pop(TaskSlot& target) noexcept
+  {
+    std::lock_guard<TaskSpinLock> guard(lock_);
+    if (back_ == front_)
+      return false;
+    --back_;
+    slots_[back_ & Mask].RelocateTo(target);
+    return true;
+  }
+
+  bool Steal(TaskSlot& target) noexcept
+  {
+    std::lock_guard<TaskSpinLock> guard(lock_);
+    if (back_ == front_)
+      return false;
+    slots_[front_ & Mask].RelocateTo(target);
+    ++front_;
+    return true;
+  }
+
+private:
+  static constexpr std::size_t Mask = TASK_EXECUTOR_QUEUE_CAPACITY - 1;
+
+  TaskSpinLock lock_;
+  std::size_t front_ = 0;
+  std::size_t back_ = 0;
+  std::unique_ptr<TaskSlot[]> slots_;
+};
+
+// Work-stealing executor
+
+class TaskExecutor
+{
+public:
+  explicit TaskExecutor(std::size_t threads = std::thread::hardware_concurrency())
+    : queues_(threads ? threads : 1)
+  {
+    workers_.reserve(queues_.size());
+    for (std::size_t i = 0; i < queues_.size(); ++i)
+      workers_.emplace_back([this, i] { Work(i); });
+  }
+
+  TaskExecutor(const TaskExecutor&) = delete;
+  TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+  // Runs every queued task, then joins the workers
+  ~TaskExecutor()
+  {
+    WaitIdle();
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_)
+      worker.join();
+  }
+
+  std::size_t ThreadCount() const noexcept { return workers_.size(); }
+
+  // Fire and forget, an exception escaping the task terminates the program
+  template <class Function, typename ...Args>
+  void Post(Function&& function, Args&&... args)
+  {
+    Enqueue<void>(nullptr, std::forward<Function>(function), std::forward<Args>(args)...);
+  }
+
+  // The result must stay alive, and must not be reused, until it is ready
+  template <class Return, class Function, typename ...Args>
+  void Submit(TaskResult<Return>& result, Function&& function, Args&&... args)
+  {
+    static_assert(std::is_same<Return, typename FunctionType<std::decay_t<Function>>::ReturnType>::value,
+      "TaskExecutor result type does not match the task's return type.");
+    Enqueue<TaskResult<Return>>(&result, std::forward<Function>(function), std::forward<Args>(args)...);
+  }
+
+  // Blocks until every submitted task has finished, must not be called from a task
+  void WaitIdle()
+  {
+    std::unique_lock<std::mutex> guard(mutex_);
+    idle_.wait(guard, [this] { return outstanding_.load() == 0; });
+  }
+
+private:
+  template <class Result, class Function, typename ...Args>
+  void Enqueue(Result* result, Function&& function, Args&&... args)
+  {
+    using Signature = FunctionType<std::decay_t<Function>>;
+    using List = typename Signature::ArgumentList;
+    using Match = std::conditional_t<List::Size == sizeof...(Args), TaskArgumentsMatch<List, Args...>, TaskArgumentsMismatch>;
+    static_assert(List::Size == sizeof...(Args), "TaskExecutor task called with the wrong number of arguments.");
+    static_assert(Match::value, "TaskExecutor task arguments are not convertible to the task's parameters.");
+    static_assert(Match::references, "TaskExecutor tasks cannot take non-const lvalue references, arguments are stored by value.");
+
+    using Body = TaskBody<std::decay_t<Function>, typename List::template Apply<TaskArguments>, Result>;
+    Body body{ std::forward<Function>(function), { std::forward<Args>(args)... }, result };
+
+    outstanding_.fetch_add(1);
+    Outstanding outstanding{ this };
+    queued_.fetch_add(1);
+    const std::size_t index = Current == this ? CurrentIndex : next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    bool pushed = false;
+    try
+    {
+      pushed = queues_[index].Push(std::move(body), pool_);
+    }
+    catch (...)
+    {
+      queued_.fetch_sub(1);
+      throw;
+    }
+    if (!pushed)
+    {
+      // Queue full, run the task on the submitting thread
+      queued_.fetch_sub(1);
+      TaskSlot slot;
+      slot.Emplace(std::move(body), pool_);
+      if constexpr (std::is_same<Result, void>::value)
+        RunPosted(slot);
+      else
+        slot.Run();
+      return;
+    }
+    outstanding.executor = nullptr;
+    if (sleeping_.load() > 0)
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      wake_.notify_one();
+    }
+  }
+
+  // Finishes a task that was not handed to a worker, also when enqueuing throws
+  struct Outstanding
+  {
+    TaskExecutor* executor;
+    ~Outstanding()
+    {
+      if (executor)
+        executor->Finish();
+    }
+  };
+
+  // A posted task that throws terminates the program, as it does on a worker
+  static void RunPosted(TaskSlot& slot) noexcept { slot.Run(); }
+
+  bool Take(std::size_t index, TaskSlot& slot) noexcept
+  {
+    if (queues_[index].Pop(slot))
+      return true;
+    for (std::size_t i = 1; i < queues_.size(); ++i)
+      if (queues_[(index + i) % queues_.size()].Steal(slot))
+        return true;
+    return false;
+  }
+
+  void Finish()
+  {
+    if (outstanding_.fetch_sub(1) == 1)
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      idle_.notify_all();
+    }
+  }
+
+  void Work(std::size_t index)
+  {
+    Current = this;
+    CurrentIndex = index;
+    TaskSlot slot;
+    for (;;)
+    {
+      if (Take(index, slot))
+      {
+        queued_.fetch_sub(1);
+        slot.Run();
+        Finish();
+        continue;
+      }
+      std::unique_lock<std::mutex> guard(mutex_);
+      sleeping_.fetch_add(1);
+      wake_.wait(guard, [this] { return queued_.load() > 0 || stop_; });
+      sleeping_.fetch_sub(1);
+      if (stop_ && queued_.load() == 0)
+        return;
+    }
+  }
+
+  static inline thread_local TaskExecutor* Current = nullptr;
+  static inline thread_local std::size_t CurrentIndex = 0;
+
+  std::vector<TaskQueue> queues_;
+  std::vector<std::thread> workers_;
+  TaskPool pool_;
+  alignas(TASK_EXECUTOR_CACHE_LINE) std::atomic<std::size_t> next_{ 0 };
+  alignas(TASK_EXECUTOR_CACHE_LINE) std::atomic<std::size_t> queued_{ 0 };
+  alignas(TASK_EXECUTOR_CACHE_LINE) std::atomic<std::size_t> outstanding_{ 0 };
+  std::atomic<std::size_t> sleeping_{ 0 };
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  bool stop_ = false;
+};
+
+#endif // TASK_EXECUTOR
@@ -24,12 +24,51 @@
 // Define this for ISO C++14 support
 //#define FUNCTION_TYPE_CPP14
 #include "FunctionType.h"
+#include "BatchInvoke.h"
+#include "FunctionInvoke.h"
+#include "FunctionRef.h"
+#include "FunctionRegistry.h"
+#include "InlineFunction.h"
+#if !defined(FUNCTION_TYPE_CPP14)
+#include "Bind.h"
+#include "CommandBuffer.h"
+#include "CTrampoline.h"
+#include "Dispatcher.h"
+#include "Instrument.h"
+#include "Memoize.h"
+#include "Pipeline.h"
+#include "Signal.h"
+#include "TaskExecutor.h"
+#if defined(__unix__)
+#include "SharedCall.h"
+#endif // __unix__
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#endif // !FUNCTION_TYPE_CPP14
 #include <iostream>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <typeinfo>
+#include <type_traits>
 
 // Name printer
 template <typename T> void PrintT() { std::cout << typeid(T).name() << std::endl; };
 
+// Runtime checks
+int Failures = 0;
+void Check(bool condition, const char* name)
+{
+  std::cout << (condition ? "Passed: " : "FAILED: ") << name << std::endl;
+  Failures += condition ? 0 : 1;
+}
+
 // Explicit deduction
 template <typename Fn>
 void Tester()
@@ -40,8 +79,13 @@ void Tester()
   std::cout << "------------------------------------------" << std::endl;
   std::cout << "Function: " << typeid(Fn).name() << std::endl;
   PrintT<typename FunctionType<Fn>::Type>();
+#if !defined(FUNCTION_TYPE_NO_TUPLE)
   PrintT<typename FunctionType<Fn>::ArgumentsType>();
+#endif // !FUNCTION_TYPE_NO_TUPLE
+  PrintT<typename FunctionType<Fn>::ArgumentList>();
   PrintT<typename FunctionType<Fn>::ReturnType>();
+  std::cout << "Arity: " << FunctionType<Fn>::Arity << std::endl;
+  PrintT<typename FunctionType<Fn>::template Arg<0>>();
   std::cout << "------------------------------------------" << std::endl;
 }
 
@@ -107,6 +151,59 @@ struct Class
   short rc_noexcept_variadic(...) const volatile&& noexcept { return 1; }
 };
 
+// Argument indexing
+using WideFunction = void(*)(char, short&, const int&, long&&, float*, double, bool, Class, Class&, const Class*);
+static_assert(FunctionType<WideFunction>::Arity == 10, "Arity");
+static_assert(FunctionType<WideFunction>::ArgumentList::Size == 10, "ArgumentList::Size");
+static_assert(std::is_same<FunctionType<WideFunction>::Arg<0>, char>::value, "Arg<0>");
+static_assert(std::is_same<FunctionType<WideFunction>::Arg<1>, short&>::value, "Arg<1>");
+static_assert(std::is_same<FunctionType<WideFunction>::Arg<2>, const int&>::value, "Arg<2>");
+static_assert(std::is_same<FunctionType<WideFunction>::Arg<3>, long&&>::value, "Arg<3>");
+static_assert(std::is_same<FunctionType<WideFunction>::Arg<9>, const Class*>::value, "Arg<9>");
+static_assert(std::is_same<FunctionType<WideFunction>::ArgumentList::At<8>, Class&>::value, "ArgumentList::At<8>");
+#if !defined(FUNCTION_TYPE_NO_TUPLE)
+static_assert(std::is_same<FunctionType<WideFunction>::ArgumentList::Apply<std::tuple>, FunctionType<WideFunction>::ArgumentsType>::value, "ArgumentList::Apply");
+#endif // !FUNCTION_TYPE_NO_TUPLE
+static_assert(FunctionType<void(*)()>::Arity == 0, "Arity of nullary function");
+
+// Qualifier metadata
+using ConstLValueMethod = short(Class::*)(int, float) const&;
+using VolatileRValueMethod = short(Class::*)(int, float) volatile&&;
+static_assert(std::is_same<FunctionType<ConstLValueMethod>::ClassType, Class>::value && FunctionType<ConstLValueMethod>::IsMember, "ClassType");
+static_assert(FunctionType<ConstLValueMethod>::IsConst && !FunctionType<ConstLValueMethod>::IsVolatile, "IsConst");
+static_assert(FunctionType<ConstLValueMethod>::RefQualifier == FunctionTypeReference::LValue, "RefQualifier lvalue");
+static_assert(!FunctionType<VolatileRValueMethod>::IsConst && FunctionType<VolatileRValueMethod>::IsVolatile, "IsVolatile");
+static_assert(FunctionType<VolatileRValueMethod>::RefQualifier == FunctionTypeReference::RValue, "RefQualifier rvalue");
+static_assert(!FunctionType<WideFunction>::IsMember && std::is_void<FunctionType<WideFunction>::ClassType>::value, "free function ClassType");
+static_assert(FunctionType<WideFunction>::RefQualifier == FunctionTypeReference::None && !FunctionType<WideFunction>::IsNoexcept, "free function qualifiers");
+auto qualifier_lambda = [](int value) { return value; };
+auto qualifier_mutable_lambda = [](int value) mutable { return value; };
+static_assert(!FunctionType<decltype(qualifier_lambda)>::IsMember && std::is_void<FunctionType<decltype(qualifier_lambda)>::ClassType>::value, "lambda ClassType");
+static_assert(!FunctionType<decltype(qualifier_lambda)>::IsConst && !FunctionType<decltype(qualifier_lambda)>::IsVolatile, "lambda cv-qualifiers");
+static_assert(FunctionType<decltype(qualifier_lambda)>::RefQualifier == FunctionTypeReference::None && !FunctionType<decltype(qualifier_lambda)>::IsNoexcept, "lambda qualifiers");
+static_assert(!FunctionType<decltype(qualifier_mutable_lambda)>::IsMember && !FunctionType<decltype(qualifier_mutable_lambda)>::IsConst, "mutable lambda qualifiers");
+#if !defined(FUNCTION_TYPE_CPP14)
+auto qualifier_noexcept_lambda = [](int value) noexcept { return value; };
+static_assert(FunctionType<decltype(qualifier_noexcept_lambda)>::IsNoexcept && !FunctionType<decltype(qualifier_noexcept_lambda)>::IsMember, "noexcept lambda qualifiers");
+static_assert(FunctionType<short(Class::*)(int, float) const volatile&& noexcept>::IsNoexcept, "IsNoexcept member");
+static_assert(FunctionType<void(*)() noexcept>::IsNoexcept, "IsNoexcept free function");
+#endif // !FUNCTION_TYPE_CPP14
+
+// Signature fingerprints
+struct Plugin { int id; };
+FUNCTION_TYPE_NAME(Plugin)
+using PluginFactory = Plugin*(*)(const char*, std::uint32_t);
+static_assert(FunctionType<PluginFactory>::Fingerprint() == FunctionType<Plugin*(*)(const char*, unsigned int)>::Fingerprint(), "Fingerprint of aliased types");
+static_assert(FunctionType<PluginFactory>::Fingerprint() != FunctionType<Plugin*(*)(char*, std::uint32_t)>::Fingerprint(), "Fingerprint of argument types");
+static_assert(FunctionType<PluginFactory>::Fingerprint() != FunctionType<const Plugin*(*)(const char*, std::uint32_t)>::Fingerprint(), "Fingerprint of return type");
+static_assert(FunctionType<void(*)(int, long)>::Fingerprint() != FunctionType<void(*)(long, int)>::Fingerprint(), "Fingerprint of argument order");
+static_assert(FunctionType<void(*)(Class&)>::Fingerprint() != FunctionType<void(*)(Class&&)>::Fingerprint(), "Fingerprint of reference kind");
+static_assert(FunctionType<ConstLValueMethod>::Fingerprint() != FunctionType<short(Class::*)(int, float) const>::Fingerprint(), "Fingerprint of ref-qualifier");
+static_assert(FunctionType<ConstLValueMethod>::Fingerprint() != FunctionType<short(*)(int, float)>::Fingerprint(), "Fingerprint of member function");
+#if !defined(FUNCTION_TYPE_CPP14)
+static_assert(FunctionType<void(*)() noexcept>::Fingerprint() != FunctionType<void(*)()>::Fingerprint(), "Fingerprint of noexcept");
+#endif // !FUNCTION_TYPE_CPP14
+
 float static_mutable(double, float) { return 1.0f; }
 float static_mutable_variadic(...) { return 1.0f; }
 float static_mutable_noexcept(double, float) noexcept { return 1.0f; }
@@ -114,6 +211,992 @@ float static_mutable_variadic_noexcept(...) noexcept { return 1.0f; }
 template <typename ...Args>
 float static_mutable_variadic_template(Args... args) noexcept { return 1.0f; }
 
+void InlineFunctionTests()
+{
+  int counter = 0;
+  auto small = MakeDelegate([&counter](int value) { counter += value; return counter; });
+  static_assert(std::is_same<decltype(small), InlineFunction<int(int)>>::value, "MakeDelegate deduced signature");
+  Check(small(2) == 2 && small(3) == 5, "InlineFunction call");
+
+  void* a = nullptr; void* b = nullptr; void* c = nullptr; void* d = nullptr;
+  auto wide = [a, b, c, d](int value) { return value + (a == b) + (c == d); };
+  InlineFunction<int(int)> copied(wide);
+  InlineFunction<int(int)> copy = copied;
+  InlineFunction<int(int)> moved = std::move(copied);
+  Check(!copied && copy(1) == 3 && moved(1) == 3, "InlineFunction copy and move");
+  copy = nullptr;
+  Check(!copy, "InlineFunction reset");
+
+  auto unique = std::make_unique<int>(7);
+  auto move_only = MakeDelegate([pointer = std::move(unique)]() { return *pointer; });
+  static_assert(!std::is_copy_constructible<decltype(move_only)>::value, "MakeDelegate move-only callable");
+  MoveOnlyInlineFunction<int()> move_only_moved = std::move(move_only);
+  Check(move_only_moved() == 7, "MoveOnlyInlineFunction call");
+
+  Class object;
+  auto member = MakeDelegate(object, &Class::variadic_template<int, float>);
+  static_assert(std::is_same<decltype(member), InlineFunction<short(int, float)>>::value, "MakeDelegate member signature");
+  Check(member(1, 1.0f) == 1, "InlineFunction member call");
+
+#if !defined(FUNCTION_TYPE_CPP14)
+  InlineFunction<int(int) noexcept> nothrow = [](int value) noexcept { return value * 2; };
+  static_assert(noexcept(nothrow(1)), "InlineFunction noexcept call operator");
+  Check(nothrow(4) == 8, "InlineFunction noexcept call");
+  auto deduced_nothrow = MakeDelegate([](int value) noexcept { return value + 1; });
+  static_assert(std::is_same<decltype(deduced_nothrow), InlineFunction<int(int) noexcept>>::value, "MakeDelegate noexcept lambda signature");
+  auto member_nothrow = MakeDelegate(object, static_cast<short(Class::*)(int, float) noexcept>(&Class::overload_noexcept));
+  static_assert(std::is_same<decltype(member_nothrow), InlineFunction<short(int, float) noexcept>>::value, "MakeDelegate noexcept member signature");
+  Check(deduced_nothrow(1) == 2 && member_nothrow(1, 1.0f) == 1, "MakeDelegate noexcept calls");
+#endif // !FUNCTION_TYPE_CPP14
+
+  auto function_pointer = MakeDelegate(&static_mutable);
+  static_assert(std::is_same<decltype(function_pointer), InlineFunction<float(double, float)>>::value, "MakeDelegate function pointer signature");
+  Check(function_pointer(1.0, 1.0f) == 1.0f, "InlineFunction function pointer call");
+}
+
+int CallFunctionRef(FunctionRef<short(int, float)> function) { return function(1, 1.0f); }
+
+void FunctionRefTests()
+{
+  int counter = 0;
+  auto lambda = [&counter](int value) { counter += value; return counter; };
+  auto reference = MakeFunctionRef(lambda);
+  static_assert(std::is_same<decltype(reference), FunctionRef<int(int)>>::value, "MakeFunctionRef deduced signature");
+  static_assert(sizeof(reference) == 2 * sizeof(void*), "FunctionRef size");
+  Check(reference(2) == 2 && reference(3) == 5 && counter == 5, "FunctionRef lambda call");
+
+  FunctionRef<float(double, float)> function = static_mutable;
+  Check(function(1.0, 1.0f) == 1.0f, "FunctionRef function call");
+  Check(MakeFunctionRef(&static_mutable)(1.0, 1.0f) == 1.0f, "MakeFunctionRef function pointer call");
+
+  Class object;
+  Check(CallFunctionRef([](int, float) { return short(1); }) == 1, "FunctionRef temporary lambda argument");
+  Check(CallFunctionRef(MakeFunctionRef<decltype(&Class::variadic_template<int, float>), &Class::variadic_template<int, float>>(object)) == 1,
+    "FunctionRef member call");
+
+#if !defined(FUNCTION_TYPE_CPP14)
+  FunctionRef deduced = lambda;
+  static_assert(std::is_same<decltype(deduced), FunctionRef<int(int)>>::value, "FunctionRef deduction guide");
+
+  FunctionRef<int(int) noexcept> nothrow = [](int value) noexcept { return value * 2; };
+  static_assert(noexcept(nothrow(1)), "FunctionRef noexcept call operator");
+  Check(nothrow(4) == 8, "FunctionRef noexcept call");
+  auto nothrow_lambda = [](int value) noexcept { return value + 1; };
+  auto deduced_nothrow = MakeFunctionRef(nothrow_lambda);
+  FunctionRef guided_nothrow = nothrow_lambda;
+  static_assert(std::is_same<decltype(deduced_nothrow), FunctionRef<int(int) noexcept>>::value && std::is_same<decltype(guided_nothrow), FunctionRef<int(int) noexcept>>::value,
+    "FunctionRef deduced noexcept signature");
+  static_assert(std::is_same<decltype(MakeFunctionRef<static_cast<short(Class::*)(int, float) noexcept>(&Class::overload_noexcept)>(object)), FunctionRef<short(int, float) noexcept>>::value,
+    "MakeFunctionRef noexcept member signature");
+  FunctionRef<int(int) noexcept> nothrow_slot = deduced_nothrow;
+  FunctionRef<int(int)> throwing_slot = deduced_nothrow;
+  Check(nothrow_slot(1) == 2 && throwing_slot(2) == 3, "FunctionRef deduced noexcept reference in noexcept and throwing slots");
+
+  // Qualifiers decide which object categories are accepted
+  const Class const_object{};
+  volatile Class volatile_object{};
+  Check(CallFunctionRef(MakeFunctionRef<static_cast<short(Class::*)(int, float)>(&Class::overload)>(object)) == 1, "FunctionRef unqualified member");
+  Check(CallFunctionRef(MakeFunctionRef<static_cast<short(Class::*)(int, float)const>(&Class::overload)>(const_object)) == 1, "FunctionRef const member");
+  Check(CallFunctionRef(MakeFunctionRef<static_cast<short(Class::*)(int, float)volatile>(&Class::overload)>(volatile_object)) == 1, "FunctionRef volatile member");
+  Check(CallFunctionRef(MakeFunctionRef<static_cast<short(Class::*)(int, float)&>(&Class::rc)>(object)) == 1, "FunctionRef lvalue member");
+  Check(CallFunctionRef(MakeFunctionRef<static_cast<short(Class::*)(int, float)const&>(&Class::rc)>(Class())) == 1, "FunctionRef const lvalue member on rvalue");
+  Check(CallFunctionRef(MakeFunctionRef<static_cast<short(Class::*)(int, float)&&>(&Class::rc)>(Class())) == 1, "FunctionRef rvalue member");
+  Check(CallFunctionRef(MakeFunctionRef<static_cast<short(Class::*)(int, float)const&&>(&Class::rc)>(std::move(const_object))) == 1, "FunctionRef const rvalue member");
+  Check(CallFunctionRef(MakeFunctionRef<static_cast<short(Class::*)(int, float)const volatile& noexcept>(&Class::rc_noexcept)>(volatile_object)) == 1, "FunctionRef const volatile lvalue noexcept member");
+  Check(CallFunctionRef(MakeFunctionRef<static_cast<short(Class::*)(int, float)volatile&& noexcept>(&Class::rc_noexcept)>(std::move(volatile_object))) == 1, "FunctionRef volatile rvalue noexcept member");
+  //MakeFunctionRef<static_cast<short(Class::*)(int, float)>(&Class::overload)>(const_object); // does not compile, const object
+  //MakeFunctionRef<static_cast<short(Class::*)(int, float)&>(&Class::rc)>(Class()); // does not compile, rvalue object
+  //MakeFunctionRef<static_cast<short(Class::*)(int, float)&&>(&Class::rc)>(object); // does not compile, lvalue object
+  //MakeFunctionRef<static_cast<short(Class::*)(int, float)const&>(&Class::rc)>(volatile_object); // does not compile, volatile object
+#endif // !FUNCTION_TYPE_CPP14
+}
+
+struct InvokeThrowingCopy
+{
+  InvokeThrowingCopy() = default;
+  InvokeThrowingCopy(const InvokeThrowingCopy&) { throw std::runtime_error("copy"); }
+  InvokeThrowingCopy(InvokeThrowingCopy&&) noexcept = default;
+};
+
+void FunctionInvokeTests()
+{
+  Class object;
+  const Class const_object{};
+  Check(FunctionInvoke(static_cast<short(Class::*)(int, float)>(&Class::overload), object, 1, 1.0f) == 1, "FunctionInvoke member on lvalue");
+  Check(FunctionInvoke(static_cast<short(Class::*)(int, float)const>(&Class::overload), &const_object, 1, 1.0f) == 1, "FunctionInvoke const member on pointer to const");
+  Check(FunctionInvoke(static_cast<short(Class::*)(int, float)&&>(&Class::rc), Class(), 1, 1.0f) == 1, "FunctionInvoke rvalue member on rvalue");
+  Check(FunctionInvoke(static_cast<short(Class::*)(int, float)const&>(&Class::rc), Class(), 1, 1.0f) == 1, "FunctionInvoke const lvalue member on rvalue");
+  Check(FunctionInvoke(&static_mutable, 1.0, 1.0f) == 1.0f, "FunctionInvoke function pointer");
+
+  int rollbacks = 0;
+  auto rollback = [&rollbacks]() { ++rollbacks; };
+  bool thrown = false;
+  try { FunctionInvokeOrRollback([](int value) -> int { if (value) throw std::runtime_error("failed"); return value; }, rollback, 1); }
+  catch (const std::runtime_error&) { thrown = true; }
+  Check(thrown && rollbacks == 1, "FunctionInvokeOrRollback rolls back and rethrows");
+  Check(FunctionInvokeOrRollback([](int value) { return value + 1; }, rollback, 1) == 2 && rollbacks == 1, "FunctionInvokeOrRollback without exception");
+
+#if !defined(FUNCTION_TYPE_CPP14)
+  auto nothrow = [](int value) noexcept { return value; };
+  auto throwing = [](int value) { return value; };
+  static_assert(FunctionTypeIsNoexcept<decltype(nothrow)> && noexcept(FunctionInvokeOrRollback(nothrow, rollback, 1)), "FunctionInvokeOrRollback noexcept lambda");
+  static_assert(!noexcept(FunctionInvoke(throwing, 1)), "FunctionInvoke potentially throwing lambda");
+  static_assert(noexcept(FunctionInvoke(static_cast<short(Class::*)(int, float) noexcept>(&Class::overload_noexcept), object, 1, 1.0f)), "FunctionInvoke noexcept member");
+  FunctionRef<int(int) noexcept> reference = nothrow;
+  static_assert(FunctionTypeIsNoexcept<decltype(reference)>, "FunctionRef noexcept metadata");
+
+  // The callee is noexcept, but copying the argument into its parameter is not
+  auto sink = [](InvokeThrowingCopy) noexcept {};
+  const InvokeThrowingCopy copied;
+  static_assert(!noexcept(FunctionInvoke(sink, copied)) && noexcept(FunctionInvoke(sink, InvokeThrowingCopy())), "FunctionInvoke throwing argument conversion");
+  thrown = false;
+  try { FunctionInvokeOrRollback(sink, rollback, copied); } catch (const std::runtime_error&) { thrown = true; }
+  Check(thrown && rollbacks == 2, "FunctionInvokeOrRollback rolls back a throwing argument conversion");
+#endif // !FUNCTION_TYPE_CPP14
+
+  //FunctionInvoke(static_cast<short(Class::*)(int, float)>(&Class::overload), const_object, 1, 1.0f); // does not compile, const object
+  //FunctionInvoke(static_cast<short(Class::*)(int, float)&>(&Class::rc), Class(), 1, 1.0f); // does not compile, rvalue object
+  //FunctionInvoke(static_cast<short(Class::*)(int, float)&&>(&Class::rc), object, 1, 1.0f); // does not compile, lvalue object
+}
+
+float Scale(float value, const double& factor) { return static_cast<float>(value * factor); }
+
+void BatchInvokeTests()
+{
+  std::vector<float> values(100000), output(values.size()), expected(values.size());
+  std::vector<double> factors(values.size(), 0.5);
+  std::iota(values.begin(), values.end(), 0.0f);
+  for (std::size_t i = 0; i < values.size(); ++i)
+    expected[i] = Scale(values[i], factors[i]);
+
+  BatchInvoke(&Scale, output, values, factors);
+  Check(output == expected, "BatchInvoke function pointer");
+  std::fill(output.begin(), output.end(), 0.0f);
+  BatchInvoke<decltype(&Scale), &Scale>(BatchSpan<float>(output.data(), output.size()), values, factors);
+  Check(output == expected, "BatchInvoke compile-time function pointer");
+
+  std::vector<int> rounded(values.size());
+  BatchInvoke([](float value) { return static_cast<int>(value) * 2; }, rounded, values);
+  Check(rounded[12345] == 24690, "BatchInvoke lambda with converted output");
+
+  std::vector<float> parallel(values.size());
+  BatchInvoke(BatchParallel(4), [](float value, double factor) { return static_cast<float>(value * factor); }, parallel, values, factors);
+  Check(parallel == expected, "BatchInvoke parallel partitioning");
+
+  int array[3] = { 1, 2, 3 }, squares[3] = {};
+  BatchInvoke([](const int& value) { return value * value; }, squares, array);
+  Check(squares[2] == 9, "BatchInvoke arrays");
+
+  bool thrown = false;
+  try { BatchInvoke(&Scale, output, values, std::vector<double>(10)); } catch (const std::length_error&) { thrown = true; }
+  Check(thrown, "BatchInvoke span size mismatch");
+
+  std::vector<float> in_place(values);
+  BatchInvoke(&Scale, in_place, in_place, factors);
+  Check(in_place == expected, "BatchInvoke in place");
+  thrown = false;
+  try { BatchInvoke([](float value) { return value; }, BatchSpan<float>(in_place.data() + 1, 10), BatchSpan<const float>(in_place.data(), 10)); } catch (const std::invalid_argument&) { thrown = true; }
+  Check(thrown, "BatchInvoke partially overlapping spans");
+
+  // The calling thread takes the last range, its exception leaves after the workers are joined
+  std::vector<int> large(2 * BATCH_INVOKE_PARALLEL_THRESHOLD), large_output(large.size());
+  large.back() = 1;
+  thrown = false;
+  try { BatchInvoke(BatchParallel(2), [](int value) { if (value) throw std::runtime_error("last"); return value; }, large_output, large); } catch (const std::runtime_error&) { thrown = true; }
+  Check(thrown, "BatchInvoke parallel exception on the calling thread");
+
+#if !defined(FUNCTION_TYPE_CPP14)
+  std::fill(output.begin(), output.end(), 0.0f);
+  BatchInvoke<&Scale>(BatchParallel(3), output, values, factors);
+  Check(output == expected, "BatchInvoke deduced compile-time function pointer");
+#endif // !FUNCTION_TYPE_CPP14
+
+  //BatchInvoke([](float&) { return 0; }, rounded, values); // does not compile, non-const reference argument
+  //BatchInvoke([](float) {}, rounded, values); // does not compile, void return
+  //BatchInvoke([](std::string) { return 0; }, rounded, values); // does not compile, not trivially copyable
+  //BatchInvoke(&Scale, output, values); // does not compile, missing input span
+}
+
+int Twice(int value) { return value * 2; }
+
+void FunctionRegistryTests()
+{
+  auto plugin = [](const char*, std::uint32_t id) { return Plugin{ static_cast<int>(id) }; };
+  Check(FunctionType<decltype(plugin)>::Fingerprint() == FunctionType<Plugin(*)(const char*, std::uint32_t)>::Fingerprint(), "Fingerprint of lambda matches function pointer");
+
+  FunctionRegistry<16> registry;
+  int calls = 0;
+  Check(registry.Register("twice", &Twice), "FunctionRegistry registers function pointer");
+  Check(registry.Register("twice", [&calls](double value) { ++calls; return value * 2.0; }), "FunctionRegistry registers a name once per signature");
+  Check(!registry.Register("twice", [](int value) { return value; }), "FunctionRegistry rejects duplicate name and signature");
+  Check(registry.Register<long(int)>("widen", [](auto value) { return static_cast<long>(value); }), "FunctionRegistry registers generic lambda with explicit signature");
+  Check(registry.Size() == 3, "FunctionRegistry size");
+
+  const FunctionRef<int(int)>* twice = registry.Find<int(int)>("twice");
+  Check(twice != nullptr && (*twice)(21) == 42, "FunctionRegistry finds by name and signature");
+  const FunctionRef<double(double)>* twiceReal = registry.Find<double(double)>("twice");
+  Check(twiceReal != nullptr && (*twiceReal)(1.5) == 3.0 && calls == 1, "FunctionRegistry finds overload by signature");
+  Check(registry.Find<long(long)>("twice") == nullptr, "FunctionRegistry rejects mismatched signature");
+  Check(registry.Register("wide", [](long value) { return value; }) && registry.Register("wide", [](long long value) { return value + 1; }), "FunctionRegistry registers types with the same size separately");
+  const FunctionRef<long long(long long)>* wide = registry.Find<long long(long long)>("wide");
+  Check(wide != nullptr && (*wide)(1) == 2 && registry.Find<long(long)>("wide") != nullptr, "FunctionRegistry finds types with the same size by exact type");
+  Check(registry.Find<unsigned long(unsigned long)>("wide") == nullptr, "FunctionRegistry rejects signature of another integer type");
+  Check(registry.Find<int(int)>("missing") == nullptr, "FunctionRegistry misses unknown name");
+
+  constexpr FunctionRegistryName widen("widen");
+  static_assert(widen.hash == FunctionRegistryName("widen", 5).hash, "FunctionRegistryName with length");
+  const FunctionRef<long(int)>* widener = registry.Find<long(int)>(widen);
+  Check(widener != nullptr && (*widener)(7) == 7L, "FunctionRegistry finds by precomputed name");
+
+  FunctionRegistry<4> small;
+  Check(small.Register("a", &Twice) && small.Register("b", &Twice) && small.Register("c", &Twice) && !small.Register("d", &Twice), "FunctionRegistry full");
+  Check(small.Find<int(int)>("d") == nullptr && small.Find<int(int)>("c") != nullptr, "FunctionRegistry lookup when full");
+
+  auto shared = std::make_shared<int>(5);
+  {
+    FunctionRegistry<4> owning;
+    owning.Register("read", [shared]() { return *shared; });
+    Check(shared.use_count() == 2 && (*owning.Find<int()>("read"))() == 5, "FunctionRegistry stores callable in place");
+  }
+  Check(shared.use_count() == 1, "FunctionRegistry destroys stored callables");
+
+  //registry.Register("method", &Class::rc_noexcept); // does not compile, member function pointer
+  //registry.Find<int>("twice"); // does not compile, not a function type
+  //registry.Register("large", [large = std::array<char, 64>()]() { return large[0]; }); // does not compile, storage too small
+}
+
+#if !defined(FUNCTION_TYPE_CPP14)
+std::size_t TaskLength(const std::string& text, std::size_t extra) { return text.size() + extra; }
+
+// Copies, but cannot be moved into the executor's queue
+struct TaskThrowingMove
+{
+  TaskThrowingMove() = default;
+  TaskThrowingMove(const TaskThrowingMove&) = default;
+  TaskThrowingMove(TaskThrowingMove&&) { throw std::runtime_error("move"); }
+};
+
+// Each move leaves one move fewer, so a task's argument can be enqueued and fail on the worker
+struct TaskFragileMove
+{
+  int moves;
+  explicit TaskFragileMove(int count) : moves(count) {}
+  TaskFragileMove(const TaskFragileMove&) = default;
+  TaskFragileMove(TaskFragileMove&& other) : moves(other.moves - 1) { if (moves < 0) throw std::runtime_error("move"); }
+};
+
+void TaskExecutorTests()
+{
+  TaskExecutor executor(4);
+  std::atomic<int> counter{ 0 };
+  for (int i = 0; i < 1000; ++i)
+    executor.Post([&counter](int value) { counter.fetch_add(value); }, 2);
+  executor.WaitIdle();
+  Check(counter.load() == 2000, "TaskExecutor Post");
+
+  TaskResult<std::size_t> length;
+  executor.Submit(length, &TaskLength, "four", 1);
+  Check(length.Get() == 5, "TaskExecutor Submit with converted arguments");
+
+  TaskResult<void> done;
+  executor.Submit(done, [&counter]() { counter.store(0); });
+  done.Get();
+  Check(counter.load() == 0, "TaskExecutor Submit void");
+
+  TaskResult<int> failed;
+  executor.Submit(failed, [](int value) -> int { throw std::runtime_error("task"); return value; }, 1);
+  bool thrown = false;
+  try { failed.Get(); } catch (const std::runtime_error&) { thrown = true; }
+  Check(thrown, "TaskExecutor Submit exception");
+
+  TaskResult<int> nothrow;
+  executor.Submit(nothrow, [](int value) noexcept { return value * 2; }, 21);
+  Check(nothrow.Get() == 42, "TaskExecutor Submit noexcept");
+
+  std::array<int, 256> large{};
+  large[255] = 7;
+  TaskResult<int> pooled;
+  executor.Submit(pooled, [large](int index) { return large[index]; }, 255);
+  Check(pooled.Get() == 7, "TaskExecutor oversized task");
+
+  TaskResult<int> nested;
+  executor.Post([&executor, &nested, &counter]()
+  {
+    for (int i = 0; i < 100; ++i)
+      executor.Post([&counter]() { counter.fetch_add(1); });
+    executor.Submit(nested, [](int value) { return value; }, 3);
+  });
+  executor.WaitIdle();
+  Check(nested.Get() == 3 && counter.load() == 100, "TaskExecutor nested submission");
+
+  // A noexcept task whose argument throws while it is moved into the parameter
+  TaskResult<int> moved;
+  const TaskFragileMove source(1);
+  executor.Submit(moved, [](TaskFragileMove) noexcept { return 1; }, source);
+  thrown = false;
+  try { moved.Get(); } catch (const std::runtime_error&) { thrown = true; }
+  Check(thrown, "TaskExecutor noexcept task with a throwing argument move");
+
+  // With the worker blocked and its queue full, tasks run on the submitting thread
+  TaskExecutor single(1);
+  std::atomic<bool> started{ false }, release{ false };
+  single.Post([&started, &release]() { started.store(true); while (!release.load()) std::this_thread::yield(); });
+  while (!started.load())
+    std::this_thread::yield();
+  for (int i = 0; i < TASK_EXECUTOR_QUEUE_CAPACITY; ++i)
+    single.Post([&counter]() { counter.fetch_add(1); });
+  TaskResult<int> inline_failed;
+  single.Submit(inline_failed, [](int value) -> int { throw std::runtime_error("task"); return value; }, 1);
+  thrown = false;
+  try { inline_failed.Get(); } catch (const std::runtime_error&) { thrown = true; }
+  thrown = thrown && inline_failed.Ready();
+  TaskThrowingMove argument;
+  bool enqueue_thrown = false;
+  try { single.Post([](TaskThrowingMove) {}, argument); } catch (const std::runtime_error&) { enqueue_thrown = true; }
+  release.store(true);
+  single.WaitIdle();
+  Check(thrown && enqueue_thrown && counter.load() == 100 + TASK_EXECUTOR_QUEUE_CAPACITY, "TaskExecutor full queue with throwing tasks");
+
+  //executor.Post([](int&) {}, 1); // does not compile, non-const lvalue reference
+  //executor.Post([](int) {}, "text"); // does not compile, argument type mismatch
+  //executor.Post([](int) {}); // does not compile, argument count mismatch
+  //executor.Submit(length, [](int value) { return value; }, 1); // does not compile, result type mismatch
+}
+
+struct KeyEvent { int key; };
+struct MouseEvent { int x; int y; };
+
+void SignalTests()
+{
+  Signal<void(int, const std::string&)> signal;
+  int total = 0;
+  const SignalConnection first = signal.Connect([&total](int value, const std::string& text) { total += value + static_cast<int>(text.size()); });
+  signal.Connect([&total](int value, std::string) { total += value; });
+  signal.Emit(1, "ab");
+  Check(total == 4 && signal.SlotCount() == 2, "Signal emit");
+  Check(signal.Disconnect(first) && !signal.Disconnect(first), "Signal disconnect");
+  signal(1, "ab");
+  Check(total == 5, "Signal emit after disconnect");
+
+  // Connecting from inside a slot must not deadlock
+  Signal<void()> reentrant;
+  int calls = 0;
+  reentrant.Connect([&reentrant, &calls]() { if (++calls == 1) reentrant.Connect([&calls]() { calls += 10; }); });
+  reentrant.Emit();
+  reentrant.Emit();
+  Check(calls == 12, "Signal connect from a slot");
+
+  Check(signal.Post(2, "x") && signal.Post(3, std::string("yz")) && signal.Dispatch() == 2 && total == 10, "Signal post and dispatch");
+
+  Signal<void(int)> bounded(2);
+  Check(bounded.Post(1) && bounded.Post(2) && !bounded.Post(3) && bounded.Dispatch() == 2, "Signal bounded queue");
+
+  // A throwing slot ends Dispatch, the next Dispatch continues after the failed event
+  Signal<void(int)> failing;
+  int seen = 0;
+  failing.Connect([&seen](int) { ++seen; });
+  failing.Connect([](int value) { if (value == 2) throw std::runtime_error("slot"); });
+  failing.Post(1);
+  failing.Post(2);
+  failing.Post(3);
+  bool thrown = false;
+  try { failing.Dispatch(); } catch (const std::runtime_error&) { thrown = true; }
+  Check(thrown && failing.Dispatch() == 1 && seen == 3, "Signal dispatch after a throwing slot");
+
+  std::atomic<int> emitted{ 0 };
+  Signal<void(int)> concurrent;
+  concurrent.Connect([&emitted](int value) { emitted.fetch_add(value); });
+  std::thread churn([&concurrent]()
+  {
+    for (int i = 0; i < 1000; ++i)
+      concurrent.Disconnect(concurrent.Connect([](int) {}));
+  });
+  for (int i = 0; i < 10000; ++i)
+    concurrent.Emit(1);
+  churn.join();
+  Check(emitted.load() == 10000 && concurrent.SlotCount() == 1, "Signal emit during connect churn");
+
+  EventBus<void(KeyEvent), void(const MouseEvent&)> bus;
+  int keys = 0, moves = 0;
+  bus.Connect([&keys](const KeyEvent& event) { keys += event.key; });
+  const SignalConnection mouse = bus.Connect([&moves](MouseEvent event) { moves += event.x + event.y; });
+  bus.Emit(KeyEvent{ 3 });
+  bus.Emit(MouseEvent{ 1, 2 });
+  bus.Post(KeyEvent{ 4 });
+  bus.Dispatch();
+  Check(keys == 7 && moves == 3, "EventBus routing");
+  Check(bus.Disconnect<void(const MouseEvent&)>(mouse), "EventBus disconnect");
+
+  //signal.Connect([](int) {}); // does not compile, argument count mismatch
+  //signal.Connect([](int, int) {}); // does not compile, argument type mismatch
+  //bus.Connect([](int) {}); // does not compile, no matching signal
+  //Signal<void(std::string&&)> moved; // does not compile, rvalue reference argument
+  //Signal<void(std::unique_ptr<int>)> owned; // does not compile, move-only argument
+}
+
+std::size_t MemoizeLength(const std::string& text, int extra) { return text.size() + static_cast<std::size_t>(extra); }
+
+// Copying into the cache throws while fragile is set
+struct FragileCopy
+{
+  static bool fragile;
+  int value;
+  FragileCopy(int v) : value(v) {}
+  FragileCopy(const FragileCopy& other) : value(other.value) { if (fragile) throw std::runtime_error("copy failed"); }
+  FragileCopy(FragileCopy&& other) noexcept : value(other.value) {}
+};
+
+bool FragileCopy::fragile = false;
+
+void MemoizeTests()
+{
+  auto length = Memoize(&MemoizeLength, 64);
+  Check(length("abc", 1) == 4 && length("abc", 1) == 4 && length("abc", 2) == 5, "Memoize results");
+  MemoizeStatistics statistics = length.Statistics();
+  Check(statistics.hits == 1 && statistics.misses == 2 && statistics.size == 2, "Memoize hit and miss counters");
+
+  int calls = 0;
+  auto square = Memoize([&calls](int value) { ++calls; return value * value; }, 4, 1);
+  for (int value : { 1, 2, 3, 4, 1, 5, 1, 6 })
+    square(value);
+  statistics = square.Statistics();
+  Check(statistics.size == 4 && statistics.evictions == 2 && statistics.hits == 2, "Memoize CLOCK eviction");
+  Check(square(1) == 1 && calls == 6, "Memoize referenced entry survives eviction");
+
+  // Concurrent misses with the same arguments call the function once
+  std::atomic<int> slow_calls{ 0 };
+  auto slow = Memoize([&slow_calls](int value)
+  {
+    slow_calls.fetch_add(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    return value + 1;
+  }, 16);
+  std::vector<std::thread> threads;
+  std::atomic<int> total{ 0 };
+  for (int i = 0; i < 8; ++i)
+    threads.emplace_back([&slow, &total]() { total.fetch_add(slow(41)); });
+  for (std::thread& thread : threads)
+    thread.join();
+  Check(slow_calls.load() == 1 && total.load() == 8 * 42 && slow.Statistics().misses == 1, "Memoize single call per key");
+
+  int attempts = 0;
+  auto flaky = Memoize([&attempts](int value) { if (++attempts == 1) throw std::runtime_error("failed"); return value; }, 8);
+  bool thrown = false;
+  try { flaky(7); } catch (const std::runtime_error&) { thrown = true; }
+  Check(thrown && flaky(7) == 7 && flaky(7) == 7 && attempts == 2, "Memoize does not cache exceptions");
+
+  int copies = 0;
+  auto fragile = Memoize([&copies](int value) { ++copies; return FragileCopy(value); }, 8);
+  FragileCopy::fragile = true;
+  thrown = false;
+  try { fragile(3); } catch (const std::runtime_error&) { thrown = true; }
+  FragileCopy::fragile = false;
+  Check(thrown && fragile(3).value == 3 && fragile(3).value == 3 && copies == 2 && fragile.Statistics().size == 1, "Memoize throwing copy into the cache");
+
+  auto bounded = Memoize([](int value) { return value; }, 10, 4);
+  for (int value = 0; value < 100; ++value)
+    bounded(value);
+  Check(bounded.Statistics().size <= 10, "Memoize total capacity");
+
+  //Memoize([](int&) { return 0; }, 8); // does not compile, non-const reference argument
+  //Memoize([](int) {}, 8); // does not compile, no return value
+}
+
+struct Login { std::string user; };
+struct Logout { int session; };
+struct Tick { double time; };
+
+void DispatcherTests()
+{
+  auto dispatcher = MakeDispatcher(
+    [](const Login& login, int& total) { total += static_cast<int>(login.user.size()); return 1; },
+    [](Logout logout, int& total) { total += logout.session; return 2; },
+    [](const Tick&, int& total) { total += 100; return 3; });
+  static_assert(decltype(dispatcher)::Size == 3 && decltype(dispatcher)::Tag<Logout> == 1, "Dispatcher tags follow handler order");
+  int total = 0;
+  std::vector<decltype(dispatcher)::Variant> messages = { Login{ "user" }, Logout{ 10 }, Tick{ 1.0 }, Logout{ 5 } };
+  int returned = 0;
+  for (const auto& message : messages)
+    returned += dispatcher(message, total);
+  Check(total == 4 + 10 + 100 + 5 && returned == 1 + 2 + 3 + 2, "Dispatcher variant messages");
+
+  Logout logout{ 7 };
+  Check(dispatcher.Dispatch(decltype(dispatcher)::Tag<Logout>, &logout, total) == 2 && total == 126, "Dispatcher tagged pointer");
+
+  std::string seen;
+  auto declared = MakeDispatcher<std::variant<Tick, Login>>(
+    [&seen](Login& login) { seen += login.user; login.user.clear(); },
+    [&seen](const Tick&) { seen += "tick"; });
+  std::variant<Tick, Login> message = Login{ "name" };
+  declared(message);
+  const bool cleared = std::get<Login>(message).user.empty();
+  message = Tick{ 0.0 };
+  declared(message);
+  Check(seen == "nametick" && cleared, "Dispatcher declared message set");
+
+  bool thrown = false;
+  try { dispatcher.Dispatch(decltype(dispatcher)::Size, &logout, total); } catch (const std::out_of_range&) { thrown = true; }
+  Check(thrown, "Dispatcher tag out of range");
+  struct Unmovable { Unmovable() = default; Unmovable(Unmovable&&) { throw std::runtime_error("move"); } };
+  std::variant<Tick, Unmovable> valueless;
+  try { valueless.emplace<Unmovable>(Unmovable()); } catch (const std::runtime_error&) {}
+  auto partial = MakeDispatcher<std::variant<Tick, Unmovable>>([](const Tick&) { return 1; }, [](const Unmovable&) { return 2; });
+  thrown = false;
+  try { partial(valueless); } catch (const std::bad_variant_access&) { thrown = true; }
+  Check(valueless.valueless_by_exception() && thrown, "Dispatcher valueless variant");
+
+  //MakeDispatcher<DispatchMessages<Login, Logout>>([](const Login&) {}); // does not compile, no handler for Logout
+  //MakeDispatcher([](const Login&) {}, [](Login) {}); // does not compile, two handlers for Login
+  //MakeDispatcher<DispatchMessages<Login>>([](const Login&) {}, [](const Tick&) {}); // does not compile, Tick is not in the message set
+  //MakeDispatcher([](const Login&) { return 1; }, [](const Tick&) {}); // does not compile, different return types
+  //MakeDispatcher([](const Login&, int) {}, [](const Tick&) {}); // does not compile, different extra arguments
+}
+
+void PipelineTests()
+{
+  auto half = [](int value) { return value * 0.5; };
+  static_assert(std::is_same<decltype(MakePipeline<int>() | half)::OutputType, double>::value, "Pipeline output type");
+
+  std::vector<std::string> received;
+  auto pipeline = MakePipeline<int>()
+    | [](int value) { return value * 2; }
+    | [](const int& value) { return std::to_string(value); }
+    | [&received](std::string text) { received.push_back(std::move(text)); };
+  {
+    auto execution = pipeline.Start({ 16, 4 });
+    for (int i = 0; i < 1000; ++i)
+      execution.Push(i);
+    execution.Finish();
+    const std::vector<PipelineStageStatistics> statistics = execution.Statistics();
+    Check(statistics.size() == 3 && statistics[0].processed == 1000 && statistics[2].processed == 1000 && statistics[1].queued == 0 && statistics[1].peak <= 16,
+      "Pipeline statistics");
+  }
+  bool ordered = received.size() == 1000;
+  for (std::size_t i = 0; ordered && i < received.size(); ++i)
+    ordered = received[i] == std::to_string(2 * i);
+  Check(ordered, "Pipeline delivers every element in order");
+
+  // A slow last stage fills the rings, the producer waits instead of growing them
+  std::atomic<int> consumed{ 0 };
+  auto slow = (MakePipeline<int>()
+    | [](int value) { return value; }
+    | [&consumed](int) { std::this_thread::sleep_for(std::chrono::microseconds(100)); consumed.fetch_add(1); }).Start({ 8, 2 });
+  for (int i = 0; i < 200; ++i)
+    slow.Push(i);
+  const std::vector<PipelineStageStatistics> pressure = slow.Statistics();
+  slow.Finish();
+  Check(consumed.load() == 200 && pressure[0].stalls + pressure[1].stalls != 0 && pressure[1].peak <= 8, "Pipeline backpressure");
+
+  // A stage that keeps up sees shallow rings, and is not busy while it waits for input
+  std::atomic<int> kept{ 0 };
+  auto paced = (MakePipeline<int>()
+    | [&kept](int) { kept.fetch_add(1); }).Start({ 1024, 4 });
+  for (int batch = 1; batch <= 25; ++batch)
+  {
+    for (int i = 0; i < 4; ++i)
+      paced.Push(i);
+    while (kept.load() != 4 * batch)
+      std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  const std::vector<PipelineStageStatistics> steady = paced.Statistics();
+  paced.Finish();
+  Check(steady[0].peak <= 4 && steady[0].stalls == 0 && steady[0].utilization < 0.5, "Pipeline depth and utilization of a stage that keeps up");
+
+  // Idle stages park, and wake for elements pushed after a pause
+  std::atomic<int> resumed{ 0 };
+  auto idle = (MakePipeline<int>()
+    | [](int value) { return value; }
+    | [&resumed](int value) { resumed.fetch_add(value); }).Start({ 8, 2 });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  idle.Push(1);
+  idle.Push(2);
+  idle.Flush();
+  while (resumed.load() != 3)
+    std::this_thread::yield();
+  idle.Finish();
+  Check(resumed.load() == 3, "Pipeline wakes idle stages");
+
+  int after = 0;
+  auto failing = (MakePipeline<int>()
+    | [](int value) { if (value == 3) throw std::runtime_error("failed"); return value; }
+    | [&after](int) { ++after; }).Start();
+  for (int i = 0; i < 10; ++i)
+    failing.Push(i);
+  bool thrown = false;
+  try { failing.Finish(); } catch (const std::runtime_error&) { thrown = true; }
+  Check(thrown && after == 3, "Pipeline rethrows a stage's exception");
+
+  //MakePipeline<int>() | [](std::string) {}; // does not compile, argument does not match
+  //MakePipeline<int>() | [](int) {} | [](int) {}; // does not compile, follows a stage that returns void
+  //MakePipeline<int>() | [](int, int) { return 0; }; // does not compile, more than one argument
+  //(MakePipeline<int>() | [](int value) { return value; }).Start(); // does not compile, last stage returns a value
+}
+
+void InstrumentTests()
+{
+  auto scaled = Instrument([](int value, const double& factor) { return value * factor; }, "InstrumentTests.scaled");
+  static_assert(std::is_same<FunctionType<decltype(scaled)>::Type, double(int, const double&)>::value, "Instrument keeps the signature");
+  InlineFunction<double(int, const double&)> slot = scaled;
+  FunctionRef<double(int, const double&)> reference = scaled;
+  double sum = 0.0;
+  for (int i = 0; i < 100; ++i)
+    sum += slot(i, 0.5) + reference(i, 0.5);
+  std::thread([&scaled, &sum]() { for (int i = 0; i < 50; ++i) sum += scaled(i, 1.0); }).join();
+
+  auto negate = Instrument([](int value) noexcept { return -value; }, "InstrumentTests.negate");
+  static_assert(FunctionType<decltype(negate)>::IsNoexcept && !FunctionType<decltype(scaled)>::IsNoexcept, "Instrument keeps noexcept");
+  InlineFunction<int(int) noexcept> nothrow_slot = negate;
+  FunctionRef<int(int) noexcept> nothrow_reference = negate;
+  Check(nothrow_slot(2) + nothrow_reference(3) == -5, "Instrument in noexcept slots");
+
+  // Exited threads and calls that throw are counted
+  auto throwing = Instrument([](int value) { if (value < 0) throw std::runtime_error("negative"); return value; }, "InstrumentTests.throwing");
+  try { throwing(-1); } catch (const std::runtime_error&) {}
+  throwing(1);
+  auto sampled = Instrument([](int value) { return value; }, "InstrumentTests.sampled", 4);
+  for (int i = 0; i < 100; ++i)
+    sampled(i);
+
+  const std::vector<InstrumentStatistics> snapshot = InstrumentSnapshot();
+  auto find = [&snapshot](const char* name)
+  {
+    for (const InstrumentStatistics& statistics : snapshot)
+      if (statistics.name == name)
+        return statistics;
+    return InstrumentStatistics();
+  };
+  const InstrumentStatistics statistics = find("InstrumentTests.scaled");
+  Check(sum == 2 * 0.5 * 4950 + 1225 && statistics.calls == 250, "Instrument counts calls across threads");
+  Check(statistics.p50 > 0.0 && statistics.p50 <= statistics.p90 && statistics.p90 <= statistics.p99 && statistics.p99 <= statistics.max * 1.07, "Instrument percentiles");
+  Check(find("InstrumentTests.throwing").calls == 2, "Instrument records calls that throw");
+  Check(find("InstrumentTests.sampled").calls == 100 && find("InstrumentTests.sampled").samples == 25, "Instrument sample period");
+
+  const std::string path = "InstrumentTests.tsv";
+  std::remove(path.c_str());
+  {
+    InstrumentAggregator aggregator(path, std::chrono::milliseconds(10));
+    std::this_thread::sleep_for(std::chrono::milliseconds(35));
+  }
+  std::ifstream file(path);
+  std::size_t lines = 0;
+  std::string line;
+  while (std::getline(file, line))
+    lines += line.find("\tInstrumentTests.scaled\t250\t") != std::string::npos ? 1 : 0;
+  file.close();
+  std::remove(path.c_str());
+  Check(lines >= 2, "InstrumentAggregator writes periodic snapshots");
+
+  //Instrument(static_cast<short(Class::*)(int, float)>(&Class::overload), "member"); // does not compile, member function pointer
+}
+
+struct Counted
+{
+  static int live;
+  Counted() { ++live; }
+  Counted(const Counted&) { ++live; }
+  ~Counted() { --live; }
+};
+
+int Counted::live = 0;
+
+void CommandBufferTests()
+{
+  std::string log;
+  CommandBuffer buffer;
+  buffer.Record([&log](const std::string& text, int count) { log.append(static_cast<std::size_t>(count), text[0]); }, "a", 2);
+  buffer.Record([&log](std::unique_ptr<int> value) { log += std::to_string(*value); }, std::make_unique<int>(7));
+  std::array<char, 3 * COMMAND_BUFFER_CHUNK_SIZE / 2> large{};
+  large[0] = 'L';
+  buffer.Record([&log](const std::array<char, 3 * COMMAND_BUFFER_CHUNK_SIZE / 2>& data) { log += data[0]; }, large);
+  for (int i = 0; i < 5000; ++i)
+    buffer.Record([&log](int value) { if (value % 1000 == 0) log += 'k'; }, i);
+  Check(buffer.Size() == 5003 && buffer.Bytes() > large.size(), "CommandBuffer records");
+  buffer.Replay();
+  Check(log == "aa7Lkkkkk" && buffer.Empty() && buffer.Bytes() == 0, "CommandBuffer replays in order");
+
+  const std::size_t capacity = buffer.Capacity();
+  buffer.Record([&log](int value) { log += std::to_string(value); }, 1);
+  buffer.Replay();
+  Check(log == "aa7Lkkkkk1" && buffer.Capacity() == capacity, "CommandBuffer reuses its arena");
+
+  // A 16 byte aligned argument recorded after an entry that ends at an 8 byte boundary
+  struct alignas(16) Wide { double values[2]; };
+  bool aligned = true;
+  int small = 0;
+  for (int i = 0; i < 3; ++i)
+  {
+    buffer.Record([&small](int value) { small += value; }, i);
+    buffer.Record([&aligned](const Wide& wide) { aligned = aligned && reinterpret_cast<std::uintptr_t>(&wide) % alignof(Wide) == 0; }, Wide{ { 1.0, 2.0 } });
+  }
+  buffer.Replay();
+  Check(aligned && small == 3, "CommandBuffer aligns over-aligned arguments");
+
+  {
+    CommandBuffer discarded;
+    discarded.Record([](const Counted&) {}, Counted());
+    discarded.Record([](Counted) {}, Counted());
+    Check(Counted::live == 2, "CommandBuffer stores arguments");
+    discarded.Clear();
+    Check(Counted::live == 0 && discarded.Empty(), "CommandBuffer Clear destroys without calling");
+    discarded.Record([](const Counted&) {}, Counted());
+  }
+  Check(Counted::live == 0, "CommandBuffer destructor destroys recorded commands");
+
+  int calls = 0;
+  buffer.Record([&calls](const Counted&) { ++calls; }, Counted());
+  buffer.Record([](int) { throw std::runtime_error("failed"); }, 0);
+  buffer.Record([&calls](const Counted&) { ++calls; }, Counted());
+  bool thrown = false;
+  try { buffer.Replay(); } catch (const std::runtime_error&) { thrown = true; }
+  Check(thrown && calls == 1 && Counted::live == 0 && buffer.Empty(), "CommandBuffer destroys the rest when a command throws");
+
+  // One thread records frames while another replays the previous one
+  DoubleCommandBuffer frames;
+  std::vector<int> replayed;
+  std::thread replayer([&frames]() { while (frames.Replay()) {} });
+  for (int frame = 0; frame < 100; ++frame)
+  {
+    for (int i = 0; i < 10; ++i)
+      frames.Record([&replayed](int value) { replayed.push_back(value); }, frame * 10 + i);
+    frames.Submit();
+  }
+  frames.Submit();
+  frames.Close();
+  replayer.join();
+  std::vector<int> expected(1000);
+  std::iota(expected.begin(), expected.end(), 0);
+  Check(replayed == expected, "DoubleCommandBuffer replays every frame in order");
+
+  //buffer.Record([](int&) {}, 1); // does not compile, non-const reference argument
+  //buffer.Record([](int, int) {}, 1); // does not compile, wrong number of arguments
+}
+
+int Digits(int hundreds, int tens, int ones) { return hundreds * 100 + tens * 10 + ones; }
+void AppendTo(std::string& text, const std::string& suffix, std::unique_ptr<int>&& count) { text += suffix + std::to_string(*count); }
+
+struct Tally
+{
+  int total = 0;
+  int Add(int value) { return total += value; }
+  int Get() const noexcept { return total; }
+};
+
+Tally GlobalTally;
+
+// Compile-time binding is stateless
+static_assert(std::is_empty<decltype(Bind<&Digits, 1, 2>)>::value, "Bind to constants is empty");
+static_assert(std::is_same<FunctionType<decltype(Bind<&Digits, 1>)>::Type, int(int, int)>::value, "Bind residual signature");
+static_assert(std::is_same<FunctionType<decltype(Bind<&Tally::Add, &GlobalTally>)>::Type, int(int)>::value, "Bind member residual signature");
+static_assert(FunctionType<decltype(Bind<&Tally::Get, &GlobalTally>)>::IsNoexcept, "Bind keeps noexcept");
+struct BindHolder : decltype(Bind<&Digits, 1, 2>) { int value; };
+static_assert(sizeof(BindHolder) == sizeof(int), "Bind to constants takes no space as a base");
+static_assert(std::is_trivially_copyable<decltype(Bind<&Digits, 1, 2>)>::value && std::is_trivially_default_constructible<decltype(Bind<&Digits, 1, 2>)>::value,
+  "Bind to constants is trivial");
+static_assert(noexcept(Bind<&Tally::Get, &GlobalTally>()), "Bind call of a noexcept function");
+
+// The callee is noexcept, converting a bound value to its parameter is not
+struct BindConversion
+{
+  BindConversion(int value) { if (value < 0) throw std::runtime_error("conversion"); }
+};
+
+void Convert(BindConversion, int) noexcept {}
+
+static_assert(!noexcept(Bind<&Convert, -1>(0)), "Bind throwing conversion of a constant");
+
+void BindTests()
+{
+  Check(Bind<&Digits, 1, 2>(3) == 123 && Bind<&Digits>(4, 5, 6) == 456, "Bind to constants");
+  Bind<&Tally::Add, &GlobalTally>(5);
+  Bind<&Tally::Add, &GlobalTally, 6>();
+  Check(GlobalTally.total == 11, "Bind member function to constant object");
+
+  auto digits = BindFront(&Digits, 7, 8);
+  Check(digits(9) == 789 && std::is_same<FunctionType<decltype(digits)>::Type, int(int)>::value, "BindFront residual signature");
+  Tally tally;
+  auto add = BindFront(&Tally::Add, &tally);
+  add(2);
+  Check(add(3) == 5, "BindFront member function");
+
+  // Stored by decreasing alignment, the stateless lambda takes no space
+  auto sum = [](double a, char b, int c, char d) { return a + b + c + d; };
+  auto bound = BindFront(sum, 1.0, 'a', 2, 'b');
+  Check(bound() == 1.0 + 'a' + 2 + 'b', "BindFront lambda");
+  Check(sizeof(bound) == sizeof(double) * 2 && sizeof(bound) < sizeof(std::tuple<decltype(sum), double, char, int, char>), "BindFront compact layout");
+
+  std::string text;
+  auto append = BindFront(&AppendTo, std::ref(text), std::string("x"));
+  append(std::make_unique<int>(1));
+  append(std::make_unique<int>(2));
+  Check(text == "x1x2", "BindFront reference and rvalue reference parameters");
+
+  // Copying a bound std::string may throw, so the call is not noexcept
+  auto length = [](const std::string& value, std::size_t extra) noexcept { return value.size() + extra; };
+  auto referenced = BindFront(length, std::ref(text));
+  auto copied = BindFront([](std::string value, std::size_t extra) noexcept { return value.size() + extra; }, std::string("x"));
+  static_assert(noexcept(referenced(1)) && !noexcept(copied(1)), "BindFront noexcept with a throwing copy");
+  Check(referenced(1) == 5 && copied(1) == 2, "BindFront noexcept function");
+  static_assert(!noexcept(Bind<&Twice, 1>()), "Bind call of a throwing function");
+  auto converted = BindFront(&Convert, -1);
+  static_assert(!noexcept(converted(0)), "BindFront throwing conversion of a value");
+  int conversions = 0;
+  try { Bind<&Convert, -1>(0); } catch (const std::runtime_error&) { ++conversions; }
+  try { converted(0); } catch (const std::runtime_error&) { ++conversions; }
+  Check(conversions == 2, "Bind throwing conversion reaches the caller");
+
+  auto curried = Curry(&Digits);
+  auto first = curried(1);
+  Check(first(2)(3) == 123 && first(4)(5) == 145, "Curry");
+  Check(std::is_same<FunctionType<decltype(curried(1)(2))>::Type, int(int)>::value, "Curry residual signature");
+  Curry(&AppendTo)(text)("y")(std::make_unique<int>(3));
+  Check(text == "x1x2y3", "Curry reference parameters");
+
+  //Bind<&Digits, 1, 2, 3, 4>; // does not compile, too many values
+  //Bind<&Tally::Add>; // does not compile, missing object
+  //Bind<&Digits, &GlobalTally>; // does not compile, value not convertible
+  //Curry(&Tally::Add); // does not compile, member function
+  //BindFront([count = 0](int value) mutable { return count += value; }); // does not compile, mutable lambda
+  //Curry([count = 0](int value) mutable { return count += value; }); // does not compile, mutable lambda
+}
+
+// A C API with the user data last, as glibc's qsort_r, and one with it first, as BSD's
+extern "C" int FoldSpans(const int* values, std::size_t size, int (*fold)(int, const void*, void*), void* context)
+{
+  int result = 0;
+  for (std::size_t i = 0; i < size; ++i)
+    result = fold(result, values + i, context);
+  return result;
+}
+
+extern "C" void VisitPairs(void (*visit)(void*, const void*, const void*), void* context, const int* values, std::size_t size)
+{
+  for (std::size_t i = 0; i + 1 < size; ++i)
+    visit(context, values + i, values + i + 1);
+}
+
+void CTrampolineTests()
+{
+  const int values[] = { 3, 1, 4, 1, 5 };
+  int calls = 0;
+  auto fold = [&calls](int sum, const int* value) { ++calls; return sum + *value; };
+  CTrampoline<int (*)(int, const void*, void*)> trailing = MakeCTrampoline<int (*)(int, const void*, void*)>(fold);
+  Check(FoldSpans(values, 5, trailing.function, trailing.context) == 14 && calls == 5 && trailing.context == &fold, "CTrampoline trailing context");
+
+  int rises = 0;
+  auto visit = [&rises](const int* first, const int* second) { rises += *second > *first ? 1 : 0; };
+  auto leading = MakeCTrampoline<void (*)(void*, const void*, const void*)>(visit);
+  VisitPairs(leading.function, leading.context, values, 5);
+  Check(rises == 2, "CTrampoline leading context");
+
+  auto explicitPosition = MakeCTrampoline<int (*)(int, const void*, const void*), 2>(fold);
+  Check(explicitPosition.function(1, values, explicitPosition.context) == 4, "CTrampoline explicit context position");
+
+  int (*compare)(const void*, const void*) = MakeCTrampoline<int (*)(const void*, const void*)>([](const void* a, const void* b) { return *static_cast<const int*>(a) - *static_cast<const int*>(b); }).function;
+  Check(compare(values, values + 1) == 2, "CTrampoline captureless lambda with the exact C signature");
+
+#if __cplusplus >= 202002L
+  auto typed = MakeCTrampoline<int (*)(const void*, const void*)>([](const int* a, const int* b) { return *a - *b; });
+  int sorted[] = { 3, 1, 2 };
+  std::qsort(sorted, 3, sizeof(int), typed.function);
+  Check(sorted[0] == 1 && sorted[2] == 3 && typed.context == nullptr, "CTrampoline context-free captureless lambda");
+  auto ignored = MakeCTrampoline<int (*)(int, const void*, void*)>([](int sum, const int* value) { return sum + *value; });
+  Check(FoldSpans(values, 5, ignored.function, ignored.context) == 14 && ignored.context == nullptr, "CTrampoline captureless lambda ignores the context");
+#endif // C++20
+
+  //MakeCTrampoline<int (*)(int, const void*)>(fold); // does not compile, stateful callable without context parameter
+  //MakeCTrampoline<int (*)(int, const void*, void*)>([&calls](int, int*) { return ++calls; }); // does not compile, const void* to int*
+  //MakeCTrampoline<int (*)(int, const void*, void*)>([&calls](int, const int*) { return ++calls; }); // does not compile, temporary callable
+  //MakeCTrampoline<void (*)(void*, void*)>([&calls](int*) { ++calls; }); // does not compile, ambiguous context
+}
+
+#if defined(__unix__)
+struct Point { float x; float y; };
+
+// Strings travel as a fixed-size buffer
+template <>
+struct SharedCallAdapter<std::string>
+{
+  struct Wire { std::uint32_t size; char data[60]; };
+  static void Encode(Wire& wire, const std::string& value)
+  {
+    wire.size = static_cast<std::uint32_t>(std::min(value.size(), sizeof(wire.data)));
+    std::memcpy(wire.data, value.data(), wire.size);
+  }
+  static std::string Decode(const Wire& wire) { return std::string(wire.data, wire.size); }
+};
+
+float Dot(Point a, const Point& b) { return a.x * b.x + a.y * b.y; }
+
+void SharedCallTests()
+{
+  using Layout = SharedCallSignature<decltype(Dot)>::Arguments;
+  static_assert(Layout::Offset<0> == 0 && Layout::Offset<1> == sizeof(Point) && Layout::Size == 2 * sizeof(Point), "SharedCall layout");
+  static_assert(SharedCallSignature<void(char, double, int)>::Arguments::Offset<1> == alignof(double), "SharedCall layout alignment");
+
+  using Interface = SharedCallInterface<decltype(Dot), std::size_t(const std::string&), void(int), int()>;
+  const std::string path = "/tmp/SharedCallTests." + std::to_string(getpid());
+  SharedCallChannel channel = SharedCallChannel::Create(path, 4096);
+  SharedCallChannel opened = SharedCallChannel::Open(path);
+  std::remove(path.c_str());
+
+  int posted = 0;
+  auto server = MakeSharedCallServer<Interface>(channel, &Dot, [](std::string text) { return text.size(); },
+    [&posted](int value) { posted += value; }, []() -> int { throw std::runtime_error("failed"); });
+  std::thread thread([&server]() { server.Run(); });
+
+  SharedCallClient<Interface> client(channel);
+  Check(client.Call<0>(Point{ 1, 2 }, Point{ 3, 4 }) == 11.0f, "SharedCall trivially copyable arguments");
+  Check(client.Call<1>(std::string("adapter")) == 7, "SharedCall adapter arguments");
+  for (int i = 1; i <= 1000; ++i)
+    client.Post<2>(i);
+  client.Flush();
+  Check(client.Call<0>(Point{ 0, 0 }, Point{ 0, 0 }) == 0.0f && posted == 500500, "SharedCall batched posts wrapping the ring");
+  bool thrown = false;
+  try { client.Call<3>(); } catch (const std::runtime_error&) { thrown = true; }
+  Check(thrown, "SharedCall handler exception");
+  client.Close();
+  thread.join();
+
+  // The same rings, mapped a second time
+  auto reopened = MakeSharedCallServer<Interface>(opened, &Dot, [](std::string text) { return text.size(); },
+    [&posted](int value) { posted = value; }, []() { return 0; });
+  client.Post<2>(-1);
+  client.Flush();
+  Check(reopened.Poll() && posted == -1, "SharedCall channel opened by path");
+
+  // A reply committed before a post handler throws is still published
+  auto failing = MakeSharedCallServer<Interface>(opened, &Dot, [](std::string text) { return text.size(); },
+    [](int value) { if (value < 0) throw std::runtime_error("post"); }, []() { return 0; });
+  float dot = 0.0f;
+  std::thread caller([&client, &dot]() { dot = client.Call<0>(Point{ 1, 1 }, Point{ 2, 2 }); });
+  while (opened.Requests().Peek(false) == nullptr)
+    std::this_thread::yield();
+  SharedCallClient<Interface> poster(opened);
+  poster.Post<2>(-1);
+  poster.Flush();
+  thrown = false;
+  try { failing.Poll(); } catch (const std::runtime_error&) { thrown = true; }
+  caller.join();
+  Check(thrown && dot == 4.0f, "SharedCall replies published when a post handler throws");
+
+  // A client with a longer interface than the server's
+  using Extended = SharedCallInterface<decltype(Dot), std::size_t(const std::string&), void(int), int(), int(int)>;
+  SharedCallClient<Extended> extended(channel);
+  thrown = false;
+  std::thread unknown([&extended, &thrown]() { try { extended.Call<4>(1); } catch (const std::runtime_error&) { thrown = true; } });
+  while (failing.Poll() && !thrown)
+    std::this_thread::yield();
+  unknown.join();
+  Check(thrown, "SharedCall call outside the server's interface");
+
+  //SharedCallSignature<void(int*)>::Arguments layout; // does not compile, pointers cannot be marshalled
+  //SharedCallSignature<void(int&)>::Arguments layout; // does not compile, non-const reference
+  //SharedCallSignature<void(std::vector<int>)>::Arguments layout; // does not compile, no adapter
+}
+#endif // __unix__
+#endif // !FUNCTION_TYPE_CPP14
+
 int main(void)
 {
   auto lambda = [](int) { return 1.0f; };
@@ -296,5 +1379,69 @@ int main(void)
   //Tester(static_cast<short(Class::*)(...)volatile&& noexcept>(&Class::rc_noexcept_variadic)); // not supported
   //Tester(static_cast<short(Class::*)(...)const volatile&& noexcept>(&Class::rc_noexcept_variadic)); // not supported
 
-  return 0;
+  std::cout << std::endl << "InlineFunction" << std::endl << std::endl;
+
+  InlineFunctionTests();
+
+  std::cout << std::endl << "FunctionRef" << std::endl << std::endl;
+
+  FunctionRefTests();
+
+  std::cout << std::endl << "FunctionInvoke" << std::endl << std::endl;
+
+  FunctionInvokeTests();
+
+  std::cout << std::endl << "BatchInvoke" << std::endl << std::endl;
+
+  BatchInvokeTests();
+
+  std::cout << std::endl << "FunctionRegistry" << std::endl << std::endl;
+
+  FunctionRegistryTests();
+
+#if !defined(FUNCTION_TYPE_CPP14)
+  std::cout << std::endl << "TaskExecutor" << std::endl << std::endl;
+
+  TaskExecutorTests();
+
+  std::cout << std::endl << "Signal" << std::endl << std::endl;
+
+  SignalTests();
+
+  std::cout << std::endl << "Memoize" << std::endl << std::endl;
+
+  MemoizeTests();
+
+  std::cout << std::endl << "Dispatcher" << std::endl << std::endl;
+
+  DispatcherTests();
+
+  std::cout << std::endl << "Pipeline" << std::endl << std::endl;
+
+  PipelineTests();
+
+  std::cout << std::endl << "Instrument" << std::endl << std::endl;
+
+  InstrumentTests();
+
+  std::cout << std::endl << "CommandBuffer" << std::endl << std::endl;
+
+  CommandBufferTests();
+
+  std::cout << std::endl << "Bind" << std::endl << std::endl;
+
+  BindTests();
+
+  std::cout << std::endl << "CTrampoline" << std::endl << std::endl;
+
+  CTrampolineTests();
+
+#if defined(__unix__)
+  std::cout << std::endl << "SharedCall" << std::endl << std::endl;
+
+  SharedCallTests();
+#endif // __unix__
+#endif // !FUNCTION_TYPE_CPP14
+
+  return Failures;
 }
\ No newline at end of file